@@ -112,7 +112,31 @@ auto Binder::BindCreate(duckdb_libpgquery::PGCreateStmt *pg_stmt) -> std::unique
     throw bustub::Exception("should have at least 1 column");
   }
 
-  return std::make_unique<CreateStatement>(std::move(table), std::move(columns));
+  // The storage format is picked with `WITH (storage = row | pax)`.
+  auto storage = TableStorage::Row;
+  for (auto c = pg_stmt->options != nullptr ? pg_stmt->options->head : nullptr; c != nullptr; c = lnext(c)) {
+    auto option = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(c->data.ptr_value);
+    if (std::string(option->defname) != "storage") {
+      throw NotImplementedException(fmt::format("unsupported table option: {}", option->defname));
+    }
+    std::string value;
+    if (option->arg != nullptr && option->arg->type == duckdb_libpgquery::T_PGString) {
+      value = reinterpret_cast<duckdb_libpgquery::PGValue *>(option->arg)->val.str;
+    } else if (option->arg != nullptr && option->arg->type == duckdb_libpgquery::T_PGTypeName) {
+      auto names = reinterpret_cast<duckdb_libpgquery::PGTypeName *>(option->arg)->names;
+      value = reinterpret_cast<duckdb_libpgquery::PGValue *>(names->tail->data.ptr_value)->val.str;
+    }
+    value = StringUtil::Lower(value);
+    if (value == "row") {
+      storage = TableStorage::Row;
+    } else if (value == "pax") {
+      storage = TableStorage::Pax;
+    } else {
+      throw NotImplementedException(fmt::format("unsupported table storage: {}", value));
+    }
+  }
+
+  return std::make_unique<CreateStatement>(std::move(table), std::move(columns), storage);
 }
 
 auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<IndexStatement> {
@@ -129,7 +153,7 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), stmt->unique);
 }
 
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "common/exception.h"
 #include "common/macros.h"
 #include "fmt/format.h"
@@ -19,112 +22,261 @@
 
 namespace bustub {
 
+BufferPoolManager::BufferPoolShard::BufferPoolShard(Page *pages, size_t pool_size, size_t replacer_k)
+    : pages_(pages),
+      pool_size_(pool_size),
+      replacer_(std::make_unique<LRUKReplacer>(pool_size, replacer_k)),
+      io_in_progress_(pool_size, false),
+      io_cv_(pool_size) {
+  // Initially, every page is in the free list.
+  for (size_t i = 0; i < pool_size_; ++i) {
+    free_list_.emplace_back(static_cast<int>(i));
+  }
+}
+
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                     LogManager *log_manager)
+                                     LogManager *log_manager, size_t num_shards,
+                                     std::optional<FrameArenaOptions> arena_options)
     : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+  BUSTUB_ENSURE(num_shards > 0 && num_shards <= pool_size, "every shard needs at least one frame");
   // we allocate a consecutive memory space for the buffer pool
   pages_ = new Page[pool_size_];
-  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  // Split the frames as evenly as possible, handing the remainder to the first shards.
+  size_t first_frame = 0;
+  for (size_t i = 0; i < num_shards; ++i) {
+    size_t shard_size = pool_size_ / num_shards + (i < pool_size_ % num_shards ? 1 : 0);
+    auto shard = std::make_unique<BufferPoolShard>(pages_ + first_frame, shard_size, replacer_k);
+    if (arena_options.has_value()) {
+      shard->arena_ = std::make_unique<FrameArena>(shard_size, arena_options->huge_pages_, arena_options->numa_policy_,
+                                                   static_cast<int>(i));
+      for (size_t frame_id = 0; frame_id < shard_size; ++frame_id) {
+        shard->pages_[frame_id].AttachData(shard->arena_->GetFrame(frame_id));
+      }
+    }
+    shards_.emplace_back(std::move(shard));
+    first_frame += shard_size;
   }
+  unused_page_ids_.resize(num_shards);
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }
+BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundFlusher();
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &thread : prefetch_threads_) {
+    thread.join();
+  }
+  delete[] pages_;
+}
 
 auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  auto page = GetAvailablePageAndInit([&]() { return this->AllocatePage(); });
-  if (page != nullptr) {
+  // The page id decides the shard, so a shard with a frame to spare is found first and the id is allocated for it.
+  // Starting from the shard of the next id spreads new pages over the shards.
+  auto first_shard = static_cast<size_t>(next_page_id_.load()) % shards_.size();
+  for (size_t i = 0; i < shards_.size(); i++) {
+    auto shard_index = (first_shard + i) % shards_.size();
+    auto &shard = *shards_[shard_index];
+    std::unique_lock<std::mutex> lock(shard.latch_);
+    // Evictable frames only become pinned under the latch, so the frame is still there when the page is placed.
+    if (shard.free_list_.empty() && shard.replacer_->Size() == 0) {
+      continue;
+    }
+    auto page = GetAvailablePageAndInit(shard, AllocatePage(shard_index), false, lock);
+    BUSTUB_ASSERT(page != nullptr, "the shard had a frame for the new page");
     *page_id = page->page_id_;
+    return page;
   }
-  return page;
+  return nullptr;
 }
 
-auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType access_type) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  auto iter = page_table_.find(page_id);
-  if (iter != page_table_.end()) {
-    auto fid = iter->second;
-    replacer_->RecordAccess(fid);
-    replacer_->SetEvictable(fid, false);
-    auto page = &pages_[fid];
-    page->pin_count_++;
-    return page;
-  }
-  auto page = GetAvailablePageAndInit([page_id = page_id]() { return page_id; }, access_type);
-  if (page != nullptr) {
-    disk_manager_->ReadPage(page_id, page->GetData());
+auto BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) -> Page * {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto fid = FindFrame(shard, page_id, lock);
+  auto &counter = fid.has_value() ? shard.hit_count_ : shard.miss_count_;
+  counter[static_cast<size_t>(access_type)]++;
+  if (fid.has_value()) {
+    return PinFrame(shard, *fid, access_type);
   }
-  return page;
+  return GetAvailablePageAndInit(shard, page_id, true, lock, access_type);
 }
 
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end()) {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto fid = FindFrame(shard, page_id, lock);
+  if (!fid.has_value()) {
     return false;
   }
-  auto fid = iter->second;
-  auto page = &pages_[fid];
-  page->is_dirty_ = page->is_dirty_ || is_dirty;
+  auto page = &shard.pages_[*fid];
+  if (is_dirty) {
+    SetDirty(shard, page, true);
+  }
   if (page->pin_count_ <= 0) {
     return false;
   }
   if (--page->pin_count_ == 0) {
-    replacer_->SetEvictable(fid, true);
+    shard.replacer_->SetEvictable(*fid, true);
   }
   return true;
 }
 
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  // One request per page, so that the background threads can read them in parallel.
+  for (auto page_id : page_ids) {
+    SubmitPrefetch([this, page_id]() { PrefetchPage(page_id, false); });
+  }
+}
+
+void BufferPoolManager::PrefetchChain(page_id_t page_id, size_t count,
+                                      std::function<page_id_t(const char *)> next_page_id) {
+  SubmitPrefetch([this, page_id, count, next_page_id = std::move(next_page_id)]() {
+    auto current = page_id;
+    for (size_t i = 0; i < count && current != INVALID_PAGE_ID; i++) {
+      auto page = PrefetchPage(current, true);
+      if (page == nullptr) {
+        return;
+      }
+      page->RLatch();
+      auto next = next_page_id(page->GetData());
+      page->RUnlatch();
+      UnpinPage(current, false, AccessType::Scan);
+      current = next;
+    }
+  });
+}
+
 auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-  return FlushPageInternal(page_id);
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  return FlushPageInternal(shard, page_id, lock);
 }
 
 void BufferPoolManager::FlushAllPages() {
-  std::scoped_lock<std::mutex> lock(latch_);
-  for (size_t frame_id = 0; frame_id < pool_size_; frame_id++) {
-    FlushPageInternal(pages_[frame_id].page_id_);
+  for (auto &shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard->latch_);
+    // Frames with I/O in flight are skipped by WriteBackFrames(): a frame being read in is clean, and the previous page
+    // of a frame being written back is already on its way to disk.
+    for (size_t first_frame = 0; first_frame < shard->pool_size_; first_frame += FLUSH_BATCH_SIZE) {
+      std::vector<frame_id_t> frame_ids;
+      for (size_t frame_id = first_frame; frame_id < std::min(first_frame + FLUSH_BATCH_SIZE, shard->pool_size_);
+           frame_id++) {
+        frame_ids.push_back(static_cast<frame_id_t>(frame_id));
+      }
+      WriteBackFrames(*shard, frame_ids, lock);
+    }
+  }
+}
+
+void BufferPoolManager::StartBackgroundFlusher(double dirty_ratio_target, std::chrono::milliseconds interval) {
+  BUSTUB_ENSURE(dirty_ratio_target >= 0 && dirty_ratio_target <= 1, "dirty ratio target must be between 0 and 1");
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    flusher_dirty_ratio_target_ = dirty_ratio_target;
+    flusher_interval_ = interval;
+    if (!flusher_thread_.joinable()) {
+      flusher_stop_ = false;
+      flusher_thread_ = std::thread([this]() { FlusherWorker(); });
+    }
+  }
+  flusher_cv_.notify_all();
+}
+
+void BufferPoolManager::StopBackgroundFlusher() {
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    flusher_stop_ = true;
+  }
+  flusher_cv_.notify_all();
+  if (flusher_thread_.joinable()) {
+    flusher_thread_.join();
+  }
+}
+
+auto BufferPoolManager::GetDirtyCount() -> size_t {
+  size_t count = 0;
+  for (auto &shard : shards_) {
+    std::scoped_lock<std::mutex> lock(shard->latch_);
+    count += shard->dirty_count_;
   }
+  return count;
 }
 
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end()) {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto fid = FindFrame(shard, page_id, lock);
+  if (!fid.has_value()) {
     return true;
   }
-  auto fid = iter->second;
-  auto page = &pages_[fid];
+  auto page = &shard.pages_[*fid];
   if (page->pin_count_ > 0) {
     return false;
   }
-  replacer_->Remove(fid);
-  free_list_.emplace_back(fid);
-  page_table_.erase(iter);
+  shard.replacer_->Remove(*fid);
+  shard.free_list_.emplace_back(*fid);
+  shard.page_table_.erase(page_id);
   page->ResetMemory();
   page->pin_count_ = 0;
-  page->is_dirty_ = false;
+  SetDirty(shard, page, false);
   page->page_id_ = INVALID_PAGE_ID;
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManager::AllocatePage() -> page_id_t { return next_page_id_++; }
+auto BufferPoolManager::GetHitCount(AccessType access_type) -> uint64_t {
+  uint64_t count = 0;
+  for (auto &shard : shards_) {
+    std::scoped_lock<std::mutex> lock(shard->latch_);
+    count += shard->hit_count_[static_cast<size_t>(access_type)];
+  }
+  return count;
+}
+
+auto BufferPoolManager::GetMissCount(AccessType access_type) -> uint64_t {
+  uint64_t count = 0;
+  for (auto &shard : shards_) {
+    std::scoped_lock<std::mutex> lock(shard->latch_);
+    count += shard->miss_count_[static_cast<size_t>(access_type)];
+  }
+  return count;
+}
+
+auto BufferPoolManager::AllocatePage(size_t shard_index) -> page_id_t {
+  if (shards_.size() == 1) {
+    return next_page_id_++;
+  }
+  std::scoped_lock<std::mutex> lock(page_id_latch_);
+  auto &unused = unused_page_ids_[shard_index];
+  if (!unused.empty()) {
+    auto page_id = unused.back();
+    unused.pop_back();
+    return page_id;
+  }
+  while (true) {
+    auto page_id = next_page_id_++;
+    auto index = static_cast<size_t>(page_id) % shards_.size();
+    if (index == shard_index) {
+      return page_id;
+    }
+    unused_page_ids_[index].push_back(page_id);
+  }
+}
 
-auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
-  auto page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  auto page = FetchPage(page_id, access_type);
   if (page == nullptr) {
     throw std::runtime_error("fail to fetch page");
   }
   return {this, page};
 }
 
-auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
-  auto page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  auto page = FetchPage(page_id, access_type);
   if (page == nullptr) {
     throw std::runtime_error("fail to fetch page");
   }
@@ -132,8 +284,8 @@ auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
   return {this, page};
 }
 
-auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
-  auto page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  auto page = FetchPage(page_id, access_type);
   if (page == nullptr) {
     throw std::runtime_error("fail to fetch page");
   }
@@ -160,46 +312,219 @@ auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
   return {this, page};
 }
 
-// not thread safe
-auto BufferPoolManager::GetAvailablePageAndInit(const std::function<page_id_t()> &page_id_generator,
-                                                AccessType access_type) -> Page * {
-  frame_id_t fid;
-  Page *page;
-  if (!free_list_.empty()) {
-    fid = free_list_.front();
-    free_list_.erase(free_list_.begin());
-    page = &pages_[fid];
-  } else {
-    auto evict = replacer_->Evict(&fid);
-    if (!evict) {
-      return nullptr;
+auto BufferPoolManager::PinFrame(BufferPoolShard &shard, frame_id_t frame_id, AccessType access_type) -> Page * {
+  shard.replacer_->RecordAccess(frame_id, access_type);
+  shard.replacer_->SetEvictable(frame_id, false);
+  auto page = &shard.pages_[frame_id];
+  page->pin_count_++;
+  return page;
+}
+
+auto BufferPoolManager::FindFrame(BufferPoolShard &shard, page_id_t page_id, std::unique_lock<std::mutex> &lock)
+    -> std::optional<frame_id_t> {
+  while (true) {
+    auto iter = shard.page_table_.find(page_id);
+    if (iter == shard.page_table_.end()) {
+      return std::nullopt;
     }
-    page = &pages_[fid];
-    if (page->IsDirty()) {
-      disk_manager_->WritePage(page->page_id_, page->GetData());
+    auto fid = iter->second;
+    if (!shard.io_in_progress_[fid]) {
+      return fid;
     }
-    page->is_dirty_ = false;
-    page->ResetMemory();
-    page_table_.erase(page->page_id_);
+    // The frame may hold a different page once the I/O completes, so look the page up again after waking up.
+    shard.io_cv_[fid].wait(lock, [&]() { return !shard.io_in_progress_[fid]; });
+  }
+}
+
+auto BufferPoolManager::GetAvailablePageAndInit(BufferPoolShard &shard, page_id_t page_id, bool read_page,
+                                                std::unique_lock<std::mutex> &lock, AccessType access_type)
+    -> Page * {
+  frame_id_t fid;
+  if (!shard.free_list_.empty()) {
+    fid = shard.free_list_.front();
+    shard.free_list_.erase(shard.free_list_.begin());
+  } else if (!shard.replacer_->Evict(&fid)) {
+    return nullptr;
   }
-  auto page_id = page_id_generator();
-  page_table_.emplace(page_id, fid);
+  auto page = &shard.pages_[fid];
+  auto old_page_id = page->page_id_;
+  auto write_back = old_page_id != INVALID_PAGE_ID && page->IsDirty();
+  if (old_page_id != INVALID_PAGE_ID && !write_back) {
+    shard.page_table_.erase(old_page_id);
+  }
+
+  // Reserve the frame for the new page. While the write back is pending, the old page id stays mapped to this frame
+  // so that a concurrent fetch of it waits for the write instead of reading a stale copy from disk.
+  shard.page_table_.emplace(page_id, fid);
   page->page_id_ = page_id;
   page->pin_count_ = 1;
-  replacer_->RecordAccess(fid, access_type);
+  SetDirty(shard, page, false);
   // recorde access init the lrunode with evictable =false;
-  // replacer_->SetEvictable(fid, false);
+  shard.replacer_->RecordAccess(fid, access_type);
+
+  if (!write_back && !read_page) {
+    page->ResetMemory();
+    return page;
+  }
+
+  shard.io_in_progress_[fid] = true;
+  lock.unlock();
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id, page->GetData());
+  }
+  page->ResetMemory();
+  if (read_page) {
+    disk_manager_->ReadPage(page_id, page->GetData());
+  }
+  lock.lock();
+
+  if (write_back) {
+    shard.page_table_.erase(old_page_id);
+  }
+  shard.io_in_progress_[fid] = false;
+  shard.io_cv_[fid].notify_all();
   return page;
 }
 
-auto BufferPoolManager::FlushPageInternal(page_id_t page_id) -> bool {
-  if (page_table_.find(page_id) == page_table_.end()) {
+void BufferPoolManager::SubmitPrefetch(std::function<void()> task) {
+  std::call_once(prefetch_threads_started_, [this]() {
+    for (int i = 0; i < PREFETCH_THREADS; i++) {
+      prefetch_threads_.emplace_back([this]() { PrefetchWorker(); });
+    }
+  });
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_tasks_.emplace_back(std::move(task));
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::PrefetchWorker() {
+  while (true) {
+    std::unique_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_cv_.wait(lock, [this]() { return prefetch_stop_ || !prefetch_tasks_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    auto task = std::move(prefetch_tasks_.front());
+    prefetch_tasks_.pop_front();
+    lock.unlock();
+    task();
+  }
+}
+
+auto BufferPoolManager::PrefetchPage(page_id_t page_id, bool keep_pinned) -> Page * {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto fid = FindFrame(shard, page_id, lock);
+  if (fid.has_value()) {
+    return keep_pinned ? PinFrame(shard, *fid, AccessType::Scan) : &shard.pages_[*fid];
+  }
+  auto page = GetAvailablePageAndInit(shard, page_id, true, lock, AccessType::Scan);
+  if (page != nullptr && !keep_pinned && --page->pin_count_ == 0) {
+    shard.replacer_->SetEvictable(static_cast<frame_id_t>(page - shard.pages_), true);
+  }
+  return page;
+}
+
+auto BufferPoolManager::FlushPageInternal(BufferPoolShard &shard, page_id_t page_id,
+                                          std::unique_lock<std::mutex> &lock) -> bool {
+  auto fid = FindFrame(shard, page_id, lock);
+  if (!fid.has_value()) {
     return false;
   }
-  auto page = &pages_[page_table_[page_id]];
-  disk_manager_->WritePage(page_id, page->GetData());
-  page->is_dirty_ = false;
+  WriteBackFrames(shard, {*fid}, lock);
   return true;
 }
 
+void BufferPoolManager::SetDirty(BufferPoolShard &shard, Page *page, bool is_dirty) {
+  if (page->is_dirty_ != is_dirty) {
+    page->is_dirty_ = is_dirty;
+    if (is_dirty) {
+      shard.dirty_count_++;
+    } else {
+      shard.dirty_count_--;
+    }
+  }
+}
+
+void BufferPoolManager::WriteBackFrames(BufferPoolShard &shard, const std::vector<frame_id_t> &frame_ids,
+                                        std::unique_lock<std::mutex> &lock) {
+  // Pinning keeps the frames from being evicted or deleted while the latch is released. No access is recorded, so
+  // writing a page back does not change its place in the eviction order.
+  std::vector<Page *> pages;
+  for (auto fid : frame_ids) {
+    auto page = &shard.pages_[fid];
+    if (page->page_id_ == INVALID_PAGE_ID || shard.io_in_progress_[fid]) {
+      continue;
+    }
+    page->pin_count_++;
+    shard.replacer_->SetEvictable(fid, false);
+    SetDirty(shard, page, false);
+    pages.push_back(page);
+  }
+  if (pages.empty()) {
+    return;
+  }
+  std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) { return a->page_id_ < b->page_id_; });
+  lock.unlock();
+
+  std::vector<char> buffer(pages.size() * BUSTUB_PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (size_t i = 0; i < pages.size(); i++) {
+    auto data = buffer.data() + i * BUSTUB_PAGE_SIZE;
+    pages[i]->RLatch();
+    memcpy(data, pages[i]->GetData(), BUSTUB_PAGE_SIZE);
+    pages[i]->RUnlatch();
+    batch.emplace_back(pages[i]->page_id_, data);
+  }
+  disk_manager_->WritePages(batch);
+
+  lock.lock();
+  for (auto page : pages) {
+    if (--page->pin_count_ == 0) {
+      shard.replacer_->SetEvictable(static_cast<frame_id_t>(page - shard.pages_), true);
+    }
+  }
+}
+
+void BufferPoolManager::FlusherWorker() {
+  std::unique_lock<std::mutex> flusher_lock(flusher_latch_);
+  while (!flusher_stop_) {
+    auto dirty_ratio_target = flusher_dirty_ratio_target_;
+    auto interval = flusher_interval_;
+    flusher_lock.unlock();
+
+    bool cleaned = false;
+    for (auto &shard : shards_) {
+      std::unique_lock<std::mutex> lock(shard->latch_);
+      if (static_cast<double>(shard->dirty_count_) <= dirty_ratio_target * static_cast<double>(shard->pool_size_)) {
+        continue;
+      }
+      // Clean the dirty pages that are closest to eviction. Only the first FLUSH_SCAN_FRAMES frames are looked at, so
+      // that a pass costs the same however large the shard is; those further back are cleaned once they come closer.
+      // Pinned pages are not in the replacer and are left alone.
+      std::vector<frame_id_t> frame_ids;
+      for (auto fid : shard->replacer_->EvictionCandidates(FLUSH_SCAN_FRAMES)) {
+        if (shard->pages_[fid].IsDirty()) {
+          frame_ids.push_back(fid);
+          if (frame_ids.size() == FLUSH_BATCH_SIZE) {
+            break;
+          }
+        }
+      }
+      if (!frame_ids.empty()) {
+        WriteBackFrames(*shard, frame_ids, lock);
+        cleaned = true;
+      }
+    }
+
+    flusher_lock.lock();
+    // Keep going while there is work, otherwise sleep until the next round or until asked to stop.
+    if (!cleaned) {
+      flusher_cv_.wait_for(flusher_lock, interval, [this]() { return flusher_stop_; });
+    }
+  }
+}
+
 }  // namespace bustub
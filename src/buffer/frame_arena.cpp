@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/** mbind() node masks are a single word here, so at most this many nodes are used. */
+static constexpr int MAX_NUMA_NODES = 64;
+
+static auto RoundUp(size_t size, size_t alignment) -> size_t { return (size + alignment - 1) / alignment * alignment; }
+
+FrameArena::FrameArena(size_t num_frames, bool huge_pages, NumaPolicy numa_policy, int numa_node) {
+  auto size = num_frames * BUSTUB_PAGE_SIZE;
+  if (huge_pages) {
+    data_size_ = RoundUp(size, HUGE_PAGE_SIZE);
+    void *addr = mmap(nullptr, data_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      mapping_ = data_ = static_cast<char *>(addr);
+      mapping_size_ = data_size_;
+      huge_tlb_ = true;
+    }
+  }
+  if (mapping_ == nullptr) {
+    // mmap only guarantees 4 KiB alignment, so map one extra alignment unit and start the frames on a boundary.
+    size_t alignment = huge_pages ? HUGE_PAGE_SIZE : BUSTUB_PAGE_SIZE;
+    data_size_ = RoundUp(size, alignment);
+    mapping_size_ = data_size_ + alignment;
+    void *addr = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map buffer pool frames");
+    }
+    mapping_ = static_cast<char *>(addr);
+    data_ = mapping_ + (alignment - reinterpret_cast<uintptr_t>(mapping_) % alignment) % alignment;
+    if (huge_pages && madvise(data_, data_size_, MADV_HUGEPAGE) != 0) {
+      LOG_DEBUG("transparent huge pages are not available for the buffer pool");
+    }
+  }
+
+  auto num_nodes = std::min(NumNumaNodes(), MAX_NUMA_NODES);
+  if (numa_policy == NumaPolicy::Default || num_nodes <= 1) {
+    return;
+  }
+  int mode;
+  uint64_t node_mask;
+  if (numa_policy == NumaPolicy::Interleave) {
+    mode = MPOL_INTERLEAVE;
+    node_mask = num_nodes == MAX_NUMA_NODES ? ~uint64_t{0} : (uint64_t{1} << num_nodes) - 1;
+  } else {
+    mode = MPOL_BIND;
+    node_mask = uint64_t{1} << (numa_node % num_nodes);
+  }
+  // The kernel reads one bit less than maxnode. Placement is only a hint for performance, so failures are not fatal.
+  if (syscall(SYS_mbind, data_, data_size_, mode, &node_mask, MAX_NUMA_NODES + 1, 0) != 0) {
+    LOG_WARN("mbind failed, buffer pool frames use the default NUMA placement");
+  }
+}
+
+FrameArena::~FrameArena() { munmap(mapping_, mapping_size_); }
+
+auto FrameArena::NumNumaNodes() -> int {
+  // The file lists node ranges, e.g. "0-3" or "0,2".
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string ranges;
+  if (!(online >> ranges)) {
+    return 1;
+  }
+  int max_node = 0;
+  size_t pos = 0;
+  while (pos < ranges.size()) {
+    auto end = ranges.find_first_of(",-", pos);
+    max_node = std::max(max_node, std::stoi(ranges.substr(pos, end - pos)));
+    if (end == std::string::npos) {
+      break;
+    }
+    pos = end + 1;
+  }
+  return max_node + 1;
+}
+
+}  // namespace bustub
@@ -15,99 +15,139 @@
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : node_store_(num_frames), history_(num_frames * k), replacer_size_(num_frames), k_(k) {
+  BUSTUB_ENSURE(k > 0, "k must be positive");
+  // Allocate every set node once; they are moved in and out of the eviction sets from now on.
+  for (size_t i = 0; i < num_frames; i++) {
+    auto fid = static_cast<frame_id_t>(i);
+    node_store_[i].handle_ = cold_frames_.extract(cold_frames_.emplace(0, fid).first);
+  }
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
   if (curr_size_ <= 0) {
     return false;
   }
-  bool seen_less_than_k = false;
-  bool seen_evictable = false;
-  frame_id_t candidate;
-  size_t min_ts;
-  for (auto &[id, cur_frame] : node_store_) {
-    if (!cur_frame.is_evictable_) {
-      continue;
-    }
-    if (cur_frame.history_.empty()) {
-      candidate = id;
-      break;
-    }
-    auto cur_earliest_ts = *cur_frame.history_.begin();
-    if (cur_frame.history_.size() < k_) {
-      if (!seen_less_than_k || cur_earliest_ts < min_ts) {
-        candidate = id;
-        min_ts = cur_earliest_ts;
-        seen_less_than_k = true;
-      }
-    } else if (!seen_less_than_k && (!seen_evictable || cur_earliest_ts < min_ts)) {
-      candidate = id;
-      min_ts = cur_earliest_ts;
-    }
-    seen_evictable = true;
-  }
-  BUSTUB_ASSERT(seen_evictable, "curr_size_ greater than 0 but cannot find evictable frame");
-  node_store_.erase(node_store_.find(candidate));
+  auto &victims = !scan_frames_.empty() ? scan_frames_ : !cold_frames_.empty() ? cold_frames_ : hot_frames_;
+  BUSTUB_ASSERT(!victims.empty(), "curr_size_ greater than 0 but cannot find evictable frame");
+  auto candidate = victims.begin()->second;
+  Unlink(candidate);
+  Reset(candidate);
   curr_size_--;
   *frame_id = candidate;
   return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id, [[maybe_unused]] AccessType access_type) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
   std::scoped_lock<std::mutex> lock(latch_);
   PreCheck(frame_id);
+  auto &frame = node_store_[frame_id];
+  bool is_scan = access_type == AccessType::Scan;
+  if (is_scan && frame.is_tracked_ && !frame.is_scan_) {
+    // A scan passing over a page of the working set neither heats it up nor cools it down.
+    return;
+  }
   current_timestamp_++;
-  auto it = node_store_.find(frame_id);
-  if (it == node_store_.end()) {
-    //    node_store_.insert(std::make_pair(frame_id, FrameMeta{frame_id}));
-    node_store_.emplace(frame_id, LRUKNode{frame_id});
-    it = node_store_.find(frame_id);
+  if (frame.is_evictable_) {
+    Unlink(frame_id);
+  }
+  frame.is_scan_ = is_scan;
+  frame.is_tracked_ = true;
+  auto *ring = &history_[frame_id * k_];
+  if (frame.history_size_ < k_) {
+    ring[(frame.history_head_ + frame.history_size_) % k_] = current_timestamp_;
+    frame.history_size_++;
+  } else {
+    ring[frame.history_head_] = current_timestamp_;
+    frame.history_head_ = (frame.history_head_ + 1) % k_;
   }
-  auto &frame = it->second;
-  frame.history_.emplace_back(current_timestamp_);
-  if (frame.history_.size() > k_) {
-    frame.history_.erase(it->second.history_.begin());
+  if (frame.is_evictable_) {
+    Link(frame_id);
   }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::scoped_lock<std::mutex> lock(latch_);
   PreCheck(frame_id);
-  auto iter = node_store_.find(frame_id);
-  if (iter == node_store_.end()) {
+  auto &frame = node_store_[frame_id];
+  if (!frame.is_tracked_ || frame.is_evictable_ == set_evictable) {
     return;
   }
-  auto &frame = iter->second;
-  if (set_evictable && !frame.is_evictable_) {
+  frame.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    Link(frame_id);
     curr_size_++;
-  } else if (!set_evictable && frame.is_evictable_) {
+  } else {
+    Unlink(frame_id);
     curr_size_--;
   }
-  frame.is_evictable_ = set_evictable;
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
   PreCheck(frame_id);
-  auto iter = node_store_.find(frame_id);
-  if (iter == node_store_.end()) {
+  auto &frame = node_store_[frame_id];
+  if (!frame.is_tracked_) {
     return;
   }
-  auto &frame = iter->second;
   if (!frame.is_evictable_) {
     throw Exception("remove non evitable frame is not allowed");
   }
-  node_store_.erase(iter);
+  Unlink(frame_id);
+  Reset(frame_id);
   curr_size_--;
 }
 
 auto LRUKReplacer::Size() -> size_t { return curr_size_; }
 
+auto LRUKReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> candidates;
+  for (auto *victims : {&scan_frames_, &cold_frames_, &hot_frames_}) {
+    for (auto iter = victims->begin(); iter != victims->end() && candidates.size() < max_frames; ++iter) {
+      candidates.push_back(iter->second);
+    }
+  }
+  return candidates;
+}
+
 void LRUKReplacer::PreCheck(frame_id_t frame_id) {
   if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw Exception("invalid frame_id");
   }
 }
 
+auto LRUKReplacer::EvictionKey(frame_id_t frame_id) -> std::pair<size_t, frame_id_t> {
+  return {history_[frame_id * k_ + node_store_[frame_id].history_head_], frame_id};
+}
+
+auto LRUKReplacer::EvictionSetOf(frame_id_t frame_id) -> LRUKNode::EvictionSet & {
+  auto &frame = node_store_[frame_id];
+  if (frame.is_scan_) {
+    return scan_frames_;
+  }
+  return frame.history_size_ < k_ ? cold_frames_ : hot_frames_;
+}
+
+void LRUKReplacer::Link(frame_id_t frame_id) {
+  auto &frame = node_store_[frame_id];
+  frame.handle_.value() = EvictionKey(frame_id);
+  EvictionSetOf(frame_id).insert(std::move(frame.handle_));
+}
+
+void LRUKReplacer::Unlink(frame_id_t frame_id) {
+  node_store_[frame_id].handle_ = EvictionSetOf(frame_id).extract(EvictionKey(frame_id));
+}
+
+void LRUKReplacer::Reset(frame_id_t frame_id) {
+  auto &frame = node_store_[frame_id];
+  frame.history_size_ = 0;
+  frame.history_head_ = 0;
+  frame.is_tracked_ = false;
+  frame.is_evictable_ = false;
+  frame.is_scan_ = false;
+}
+
 }  // namespace bustub
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <optional>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
+#include <vector>
 
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
@@ -28,12 +31,14 @@
 #include "execution/plans/abstract_plan.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "fmt/ranges.h"
 #include "optimizer/optimizer.h"
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -163,6 +168,113 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayIndexStats(ResultWriter &writer) {
+  auto table_names = catalog_->GetTableNames();
+  auto num_threads = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+  // Histograms are printed after the summary, which is written out index by index as each walk finishes.
+  std::vector<std::tuple<std::string, std::string, size_t>> histograms;
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("table_name");
+  writer.WriteHeaderCell("index_name");
+  writer.WriteHeaderCell("height");
+  writer.WriteHeaderCell("pages");
+  writer.WriteHeaderCell("fill");
+  writer.WriteHeaderCell("keys");
+  writer.WriteHeaderCell("underfull");
+  writer.WriteHeaderCell("chain_breaks");
+  writer.WriteHeaderCell("integrity");
+  writer.EndHeader();
+  for (const auto &table_name : table_names) {
+    for (const auto *index_info : catalog_->GetTableIndexes(table_name)) {
+      // Unique and non-unique indexes have keys of different sizes, and so trees of different types.
+      auto write_stats = [&](auto *index) {
+        auto stats = index->Analyze(num_threads);
+        std::vector<std::string> fills;
+        for (int level = 0; level < stats.height_; level++) {
+          fills.push_back(fmt::format("{:.0f}%", stats.FillFactor(level) * 100));
+        }
+        writer.BeginRow();
+        writer.WriteCell(table_name);
+        writer.WriteCell(index_info->name_);
+        writer.WriteCell(fmt::format("{}", stats.height_));
+        writer.WriteCell(fmt::format("{}", fmt::join(stats.pages_, "/")));
+        writer.WriteCell(fmt::format("{}", fmt::join(fills, "/")));
+        writer.WriteCell(fmt::format("{}", stats.height_ > 0 ? stats.entries_.back() : 0));
+        writer.WriteCell(fmt::format("{}", stats.underfull_pages_));
+        writer.WriteCell(fmt::format("{}", stats.leaf_chain_breaks_));
+        if (!stats.is_quiescent_) {
+          writer.WriteCell("not checked, modified during the walk");
+        } else {
+          writer.WriteCell(stats.num_errors_ == 0
+                               ? "ok"
+                               : fmt::format("{} errors: {}", stats.num_errors_, fmt::join(stats.errors_, "; ")));
+        }
+        writer.EndRow();
+
+        auto *key_schema = index->GetKeySchema();
+        for (const auto &[key, num_keys] : stats.histogram_) {
+          std::vector<std::string> columns;
+          for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+            columns.push_back(key.ToValue(key_schema, i).ToString());
+          }
+          histograms.emplace_back(index_info->name_, fmt::format("({})", fmt::join(columns, ", ")), num_keys);
+        }
+      };
+      if (auto *index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get()); index != nullptr) {
+        write_stats(index);
+      } else if (auto *non_unique_index =
+                     dynamic_cast<NonUniqueBPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
+                 non_unique_index != nullptr) {
+        write_stats(non_unique_index);
+      }
+    }
+  }
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("index_name");
+  writer.WriteHeaderCell("from_key");
+  writer.WriteHeaderCell("keys");
+  writer.EndHeader();
+  for (const auto &[index_name, from_key, num_keys] : histograms) {
+    writer.BeginRow();
+    writer.WriteCell(index_name);
+    writer.WriteCell(from_key);
+    writer.WriteCell(fmt::format("{}", num_keys));
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
+void BustubInstance::CmdVacuum(ResultWriter &writer) {
+  auto table_names = catalog_->GetTableNames();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("table_name");
+  writer.WriteHeaderCell("pages");
+  writer.WriteHeaderCell("pages_vacuumed");
+  writer.WriteHeaderCell("tuples_removed");
+  writer.WriteHeaderCell("free_bytes");
+  writer.EndHeader();
+  for (const auto &table_name : table_names) {
+    auto *table_info = catalog_->GetTable(table_name);
+    if (table_info->table_ == nullptr) {
+      continue;
+    }
+    auto stats = table_info->table_->Vacuum();
+    writer.BeginRow();
+    writer.WriteCell(table_name);
+    writer.WriteCell(fmt::format("{}", stats.pages_));
+    writer.WriteCell(fmt::format("{}", stats.pages_vacuumed_));
+    writer.WriteCell(fmt::format("{}", stats.tuples_removed_));
+    writer.WriteCell(fmt::format("{}", stats.free_bytes_));
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -176,6 +288,8 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\di+: show the statistics of all B+ tree indices and, if no query modifies them meanwhile, check their integrity
+\vacuum: remove deleted tuples from all tables and show how much space is free
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -216,6 +330,14 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\di+") {
+      CmdDisplayIndexStats(writer);
+      return true;
+    }
+    if (sql == "\\vacuum") {
+      CmdVacuum(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
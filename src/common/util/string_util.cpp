@@ -36,6 +36,9 @@ void StringUtil::RTrim(std::string *str) {
 auto StringUtil::Indent(int num_indent) -> std::string { return std::string(num_indent, ' '); }  // NOLINT
 
 auto StringUtil::StartsWith(const std::string &str, const std::string &prefix) -> bool {
+  if (prefix.size() > str.size()) {
+    return false;
+  }
   return std::equal(prefix.begin(), prefix.end(), str.begin());
 }
 
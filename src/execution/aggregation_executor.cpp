@@ -27,9 +27,9 @@ AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const Aggreg
 void AggregationExecutor::Init() {
   child_->Init();
   aht_.Clear();
-  Tuple tuple;
+  TupleRef tuple;
   RID rid;
-  while (child_->Next(&tuple, &rid)) {
+  while (child_->NextRef(&tuple, &rid)) {
     aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
   }
   if (aht_.Empty() && plan_->GetGroupBys().empty()) {
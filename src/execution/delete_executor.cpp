@@ -30,10 +30,10 @@ auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (is_end_) {
     return false;
   }
-  Tuple child_tuple{};
+  TupleRef child_tuple{};
   RID child_rid{};
   int32_t cnt = 0;
-  while (child_executor_->Next(&child_tuple, &child_rid)) {
+  while (child_executor_->NextRef(&child_tuple, &child_rid)) {
     DeleteTuple(&child_tuple, child_rid);
     cnt++;
   }
@@ -42,7 +42,7 @@ auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   return true;
 }
 
-void DeleteExecutor::DeleteTuple(Tuple *tuple, RID rid) {
+void DeleteExecutor::DeleteTuple(const TupleRef *tuple, RID rid) {
   auto tuple_meta = table_info_->table_->GetTupleMeta(rid);
   BUSTUB_ASSERT(!tuple_meta.is_deleted_, "delete executor should not receive any deleted tuple");
   for (IndexInfo *index_info : index_infos_) {
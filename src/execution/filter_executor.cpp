@@ -13,12 +13,14 @@ void FilterExecutor::Init() {
   child_executor_->Init();
 }
 
-auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool { return NextFromRef(tuple, rid); }
+
+auto FilterExecutor::NextRef(TupleRef *tuple, RID *rid) -> bool {
   auto filter_expr = plan_->GetPredicate();
 
   while (true) {
     // Get the next tuple
-    const auto status = child_executor_->Next(tuple, rid);
+    const auto status = child_executor_->NextRef(tuple, rid);
 
     if (!status) {
       return false;
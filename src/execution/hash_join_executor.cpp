@@ -32,9 +32,9 @@ HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlan
 void HashJoinExecutor::Init() {
   ht_.clear();
   right_executor_->Init();
-  Tuple tuple;
+  TupleRef tuple;
   RID rid;
-  while (right_executor_->Next(&tuple, &rid)) {
+  while (right_executor_->NextRef(&tuple, &rid)) {
     const auto &right_key = GetRightJoinKey(&tuple);
     auto iter = ht_.find(right_key);
     if (iter == ht_.end()) {
@@ -92,15 +92,15 @@ auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   return find_right;
 }
 
-auto HashJoinExecutor::GetLeftJoinKey(const Tuple *tuple) -> JoinKey {
+auto HashJoinExecutor::GetLeftJoinKey(const TupleRef *tuple) -> JoinKey {
   return JoinKey{GetJoinKeys(tuple, left_executor_->GetOutputSchema(), plan_->LeftJoinKeyExpressions())};
 }
 
-auto HashJoinExecutor::GetRightJoinKey(const Tuple *tuple) -> JoinKey {
+auto HashJoinExecutor::GetRightJoinKey(const TupleRef *tuple) -> JoinKey {
   return JoinKey{GetJoinKeys(tuple, right_executor_->GetOutputSchema(), plan_->RightJoinKeyExpressions())};
 }
 
-auto HashJoinExecutor::GetJoinKeys(const Tuple *tuple, const Schema &schema,
+auto HashJoinExecutor::GetJoinKeys(const TupleRef *tuple, const Schema &schema,
                                    const std::vector<AbstractExpressionRef> &expressions) const -> std::vector<Value> {
   std::vector<Value> join_keys;
   join_keys.reserve(expressions.size());
@@ -114,7 +114,7 @@ void HashJoinExecutor::GetNextLeftTuple() {
   last_left_match_ = false;
   right_end_opt_.reset();
   RID left_rid;
-  left_end_ = !left_executor_->Next(&left_tuple_, &left_rid);
+  left_end_ = !left_executor_->NextRef(&left_tuple_, &left_rid);
   if (!left_end_) {
     if (auto iter = ht_.find(GetLeftJoinKey(&left_tuple_)); iter != ht_.end()) {
       right_iter_ = iter->second.begin();
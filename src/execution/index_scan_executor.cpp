@@ -9,32 +9,102 @@
 // Copyright (c) 2015-19, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <functional>
+#include <utility>
+#include <vector>
+
 #include "execution/executors/index_scan_executor.h"
 
 namespace bustub {
+
+/**
+ * Make a scan over a range of a tree's key, whose bounds are values of its first column. Each call hands out the RIDs
+ * of the next leaf and releases it before returning, so that no leaf stays latched while the rows are handed out: an
+ * update or delete above the scan changes the index. The next call descends the tree again and goes on past the last
+ * key handed out, which is unique in the tree as non-unique indexes order equal keys by RID.
+ */
+template <typename KeyType, typename KeyComparator>
+static auto ScanLeaves(BPlusTreeIndex<KeyType, RID, KeyComparator> *tree_index, const Schema &key_schema,
+                       const IndexScanRange &range, bool reverse) -> std::function<bool(std::vector<RID> *)> {
+  auto to_key = [&key_schema](const Value &value) {
+    KeyType key;
+    key.SetFromKey(Tuple({value.CastAs(key_schema.GetColumn(0).GetType())}, &key_schema), key_schema);
+    return key;
+  };
+  KeyRange<KeyType> key_range;
+  if (range.lower_.has_value()) {
+    key_range.lower_ = to_key(*range.lower_);
+    key_range.lower_inclusive_ = range.lower_inclusive_;
+  }
+  if (range.upper_.has_value()) {
+    key_range.upper_ = to_key(*range.upper_);
+    key_range.upper_inclusive_ = range.upper_inclusive_;
+  }
+  return [tree_index, key_range, reverse, is_end = false](std::vector<RID> *rids) mutable {
+    if (is_end) {
+      return false;
+    }
+    // The scan stops at the end of the leaf rather than moving on, which would latch (and read ahead) the next one.
+    auto iter = tree_index->GetRangeIterator(key_range, reverse);
+    while (!iter.IsEnd()) {
+      const auto &[key, rid] = *iter;
+      rids->push_back(rid);
+      if (reverse) {
+        key_range.upper_ = key;
+        key_range.upper_inclusive_ = false;
+      } else {
+        key_range.lower_ = key;
+        key_range.lower_inclusive_ = false;
+      }
+      if (iter.IsLastInLeaf()) {
+        return true;
+      }
+      ++iter;
+    }
+    is_end = true;
+    return !rids->empty();
+  };
+}
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
     : AbstractExecutor(exec_ctx), plan_(plan) {}
 
 void IndexScanExecutor::Init() {
   index_info_ = exec_ctx_->GetCatalog()->GetIndex(plan_->GetIndexOid());
   table_info_ = exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_);
-  auto *tree_index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info_->index_.get());
-  index_iter_ = tree_index->GetBeginIterator();
+  const auto &range = plan_->GetRange();
+  const auto &key_schema = index_info_->key_schema_;
+  BUSTUB_ASSERT(range.IsFull() || key_schema.GetColumnCount() == 1, "range scans need a single-column index");
+  auto *index = index_info_->index_.get();
+  if (auto *tree_index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index); tree_index != nullptr) {
+    next_leaf_ = ScanLeaves(tree_index, key_schema, range, plan_->IsReverse());
+  } else {
+    auto *non_unique_index = dynamic_cast<NonUniqueBPlusTreeIndexForTwoIntegerColumn *>(index);
+    BUSTUB_ASSERT(non_unique_index != nullptr, "index scans need a B+ tree index");
+    next_leaf_ = ScanLeaves(non_unique_index, key_schema, range, plan_->IsReverse());
+  }
+  rids_.clear();
+  rid_index_ = 0;
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  while (!index_iter_.IsEnd()) {
-    auto tmp_rid = (*index_iter_).second;
-    ++index_iter_;
+  while (true) {
+    if (rid_index_ == rids_.size()) {
+      rids_.clear();
+      rid_index_ = 0;
+      if (!next_leaf_(&rids_)) {
+        return false;
+      }
+    }
+    auto tmp_rid = rids_[rid_index_++];
     auto result = table_info_->table_->GetTuple(tmp_rid);
     if (result.first.is_deleted_) {
       continue;
     }
-    *tuple = result.second;
+    *tuple = std::move(result.second);
     *rid = tmp_rid;
     return true;
   }
-  return false;
 }
 
 }  // namespace bustub
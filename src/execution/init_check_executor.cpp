@@ -37,4 +37,13 @@ auto InitCheckExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   return result;
 }
 
+auto InitCheckExecutor::NextRef(TupleRef *tuple, RID *rid) -> bool {
+  // Emit the next tuple
+  auto result = child_executor_->NextRef(tuple, rid);
+  if (result) {
+    n_next_++;
+  }
+  return result;
+}
+
 }  // namespace bustub
@@ -30,10 +30,10 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (is_end_) {
     return false;
   }
-  Tuple child_tuple{};
+  TupleRef child_tuple{};
   RID child_rid{};
   int32_t cnt = 0;
-  while (child_executor_->Next(&child_tuple, &child_rid)) {
+  while (child_executor_->NextRef(&child_tuple, &child_rid)) {
     if (InsertTupleAndIndices(child_tuple, exec_ctx_->GetTransaction())) {
       cnt++;
     }
@@ -43,7 +43,7 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   return true;
 }
 
-auto InsertExecutor::InsertTupleAndIndices(Tuple &tuple, Transaction *txn) -> bool {
+auto InsertExecutor::InsertTupleAndIndices(const TupleRef &tuple, Transaction *txn) -> bool {
   auto rid = table_info_->table_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple,
                                               exec_ctx_->GetLockManager(), txn);
   if (!rid.has_value()) {
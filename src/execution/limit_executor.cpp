@@ -34,4 +34,15 @@ auto LimitExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   return false;
 }
 
+auto LimitExecutor::NextRef(TupleRef *tuple, RID *rid) -> bool {
+  if (offset_ >= plan_->GetLimit()) {
+    return false;
+  }
+  if (child_executor_->NextRef(tuple, rid)) {
+    offset_++;
+    return true;
+  }
+  return false;
+}
+
 }  // namespace bustub
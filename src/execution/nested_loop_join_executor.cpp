@@ -39,11 +39,11 @@ auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   if (left_end_) {
     return false;
   }
-  Tuple right_tuple;
+  TupleRef right_tuple;
   RID right_id;
   bool find_right = false;
   while (!find_right && !left_end_) {
-    while (right_executor_->Next(&right_tuple, &right_id)) {
+    while (right_executor_->NextRef(&right_tuple, &right_id)) {
       auto equal = plan_->Predicate()->EvaluateJoin(&left_tuple_, left_executor_->GetOutputSchema(), &right_tuple,
                                                     right_executor_->GetOutputSchema());
       if (equal.GetAs<bool>()) {
@@ -86,7 +86,7 @@ auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
 void NestedLoopJoinExecutor::RightExecutorInit() {
   last_left_match_ = false;
   RID left_rid;
-  left_end_ = !left_executor_->Next(&left_tuple_, &left_rid);
+  left_end_ = !left_executor_->NextRef(&left_tuple_, &left_rid);
   if (!left_end_) {
     right_executor_->Init();
   }
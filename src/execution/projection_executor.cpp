@@ -13,10 +13,10 @@ void ProjectionExecutor::Init() {
 }
 
 auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  Tuple child_tuple{};
+  TupleRef child_tuple{};
 
   // Get the next tuple
-  const auto status = child_executor_->Next(&child_tuple, rid);
+  const auto status = child_executor_->NextRef(&child_tuple, rid);
 
   if (!status) {
     return false;
@@ -18,21 +18,32 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
     : AbstractExecutor(exec_ctx), plan_(plan) {}
 
 void SeqScanExecutor::Init() {
-  iter_ = std::make_unique<TableIterator>(exec_ctx_->GetCatalog()->GetTable(plan_->table_oid_)->table_->MakeIterator());
+  iter_ = std::make_unique<TableIterator>(
+      exec_ctx_->GetCatalog()->GetTable(plan_->table_oid_)->table_->MakeIterator(plan_->columns_));
+  batch_.clear();
+  batch_index_ = 0;
 }
 
-auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  while (!iter_->IsEnd()) {
-    auto [tuple_meta, cur_tuple] = iter_->GetTuple();
-    ++(*iter_);
+auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return NextFromRef(tuple, rid); }
+
+auto SeqScanExecutor::NextRef(TupleRef *tuple, RID *rid) -> bool {
+  while (true) {
+    // Tuples come from the table a page at a time.
+    if (batch_index_ == batch_.size()) {
+      batch_ = iter_->NextBatch();
+      batch_index_ = 0;
+      if (batch_.empty()) {
+        return false;
+      }
+    }
+    const auto &[tuple_meta, cur_tuple] = batch_[batch_index_++];
     if (!tuple_meta.is_deleted_ &&
         (plan_->filter_predicate_ == nullptr ||
          plan_->filter_predicate_->Evaluate(&cur_tuple, plan_->OutputSchema()).GetAs<bool>())) {
-      *tuple = cur_tuple;
       *rid = cur_tuple.GetRid();
+      *tuple = cur_tuple;
       return true;
     }
   }
-  return false;
 }
 }  // namespace bustub
@@ -9,6 +9,7 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <cstring>
 #include <memory>
 
 #include "execution/executors/update_executor.h"
@@ -31,20 +32,16 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (is_end_) {
     return false;
   }
-  Tuple old_tuple;
+  TupleRef old_tuple;
   RID old_rid;
   int32_t cnt = 0;
-  while (child_executor_->Next(&old_tuple, &old_rid)) {
-    // delete tuple
+  while (child_executor_->NextRef(&old_tuple, &old_rid)) {
+    // An index scan below may come across a tuple again under its new key, which is not updated twice.
+    if (updated_rids_.count(old_rid) > 0) {
+      continue;
+    }
     auto tuple_meta = table_info_->table_->GetTupleMeta(old_rid);
     BUSTUB_ASSERT(!tuple_meta.is_deleted_, "update executor should not receive any deleted tuple");
-    for (IndexInfo *index_info : index_infos_) {
-      Tuple key_tuple =
-          old_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, index_info->index_->GetKeyAttrs());
-      index_info->index_->DeleteEntry(key_tuple, old_rid, exec_ctx_->GetTransaction());
-    }
-    tuple_meta.is_deleted_ = true;
-    table_info_->table_->UpdateTupleMeta(tuple_meta, old_rid);
 
     // manufacture new tuple
     std::vector<Value> new_values;
@@ -54,6 +51,33 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     }
     Tuple new_tuple(new_values, &child_executor_->GetOutputSchema());
 
+    // update tuple in place, which keeps its rid, so only the indexes whose key changed need new entries
+    if (table_info_->table_->UpdateTuple(tuple_meta, new_tuple, old_rid)) {
+      for (IndexInfo *index_info : index_infos_) {
+        const auto &key_attrs = index_info->index_->GetKeyAttrs();
+        Tuple old_key = old_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, key_attrs);
+        Tuple new_key = new_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, key_attrs);
+        if (old_key.GetLength() == new_key.GetLength() &&
+            memcmp(old_key.GetData(), new_key.GetData(), old_key.GetLength()) == 0) {
+          continue;
+        }
+        index_info->index_->DeleteEntry(old_key, old_rid, exec_ctx_->GetTransaction());
+        index_info->index_->InsertEntry(new_key, old_rid, exec_ctx_->GetTransaction());
+      }
+      updated_rids_.insert(old_rid);
+      cnt++;
+      continue;
+    }
+
+    // without room for even a forwarding address, fall back to deleting the tuple and inserting the new one
+    for (IndexInfo *index_info : index_infos_) {
+      Tuple key_tuple =
+          old_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, index_info->index_->GetKeyAttrs());
+      index_info->index_->DeleteEntry(key_tuple, old_rid, exec_ctx_->GetTransaction());
+    }
+    tuple_meta.is_deleted_ = true;
+    table_info_->table_->UpdateTupleMeta(tuple_meta, old_rid);
+
     // insert new tuple
     auto new_rid = table_info_->table_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, new_tuple,
                                                     exec_ctx_->GetLockManager(), exec_ctx_->GetTransaction());
@@ -65,6 +89,7 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
           new_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, index_info->index_->GetKeyAttrs());
       index_info->index_->InsertEntry(key_tuple, new_rid.value(), exec_ctx_->GetTransaction());
     }
+    updated_rids_.insert(*new_rid);
     cnt++;
   }
   *tuple = Tuple{{{INTEGER, cnt}}, &GetOutputSchema()};
@@ -12,11 +12,20 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <optional>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/frame_arena.h"
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
 #include "recovery/log_manager.h"
@@ -28,6 +37,14 @@ namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The pool may be split into several shards. A page always lives in the shard selected by its page id, and every
+ * shard has its own latch, page table, free list and replacer, so threads working on pages of different shards never
+ * contend with each other. With a single shard the pool behaves like a classic single-latch buffer pool.
+ *
+ * By default every frame's data is a separate heap allocation, which lets AddressSanitizer catch page overflows. Large
+ * pools should pass FrameArenaOptions instead, so that each shard keeps its frames in one FrameArena backed by huge
+ * pages and placed according to the NUMA policy.
  */
 class BufferPoolManager {
  public:
@@ -37,9 +54,12 @@ class BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param num_shards the number of independent partitions the frames are split into
+   * @param arena_options if set, hold the frames of each shard in a FrameArena with these options
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                    LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr, size_t num_shards = 1,
+                    std::optional<FrameArenaOptions> arena_options = std::nullopt);
 
   /**
    * @brief Destroy an existing BufferPoolManager.
@@ -52,6 +72,15 @@ class BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @brief Return the number of shards the buffer pool is partitioned into. */
+  auto GetNumShards() -> size_t { return shards_.size(); }
+
+  /** @brief Return how many fetches of the given access type found their page already in the pool. */
+  auto GetHitCount(AccessType access_type) -> uint64_t;
+
+  /** @brief Return how many fetches of the given access type had to bring their page in from disk. */
+  auto GetMissCount(AccessType access_type) -> uint64_t;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -99,7 +128,8 @@ class BufferPoolManager {
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPage().
    *
    * @param page_id id of page to be fetched
-   * @param access_type type of access to the page, only needed for leaderboard tests.
+   * @param access_type type of access to the page. Pages fetched by sequential scans should pass AccessType::Scan so
+   * that the replacer evicts them before the rest of the working set.
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
   auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
@@ -115,13 +145,38 @@ class BufferPoolManager {
    * the returned page already has a read or write latch held, respectively.
    *
    * @param page_id, the id of the page to fetch
+   * @param access_type type of access to the page, see FetchPage()
    * @return PageGuard holding the fetched page
    */
-  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
-  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
-  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
   //  auto FetchPageScan(page_id_t page_id) -> ReadPageGuard;
 
+  /**
+   * @brief Asynchronously bring pages into the buffer pool.
+   *
+   * Each page that is not already cached is read by a background I/O thread into an unpinned frame, as if it had been
+   * fetched with AccessType::Scan and unpinned right away. The call returns immediately. Prefetching is best effort: a
+   * page is skipped if every frame of its shard is pinned.
+   *
+   * @param page_ids ids of the pages to prefetch
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Asynchronously bring a chain of linked pages into the buffer pool.
+   *
+   * Starting with page_id, a background I/O thread loads up to count pages, using next_page_id on the data of each
+   * page to find the one after it. This is meant for read-ahead along TableHeap pages and B+ tree leaves, where the
+   * next page id is only known once the current page has been read.
+   *
+   * @param page_id id of the first page of the chain
+   * @param count maximum number of pages to load
+   * @param next_page_id returns the id of the page that follows the given page data, or INVALID_PAGE_ID at the end
+   */
+  void PrefetchChain(page_id_t page_id, size_t count, std::function<page_id_t(const char *)> next_page_id);
+
   /**
    * TODO(P1): Add implementation
    *
@@ -155,9 +210,34 @@ class BufferPoolManager {
    * TODO(P1): Add implementation
    *
    * @brief Flush all the pages in the buffer pool to disk.
+   *
+   * The pool is written back FLUSH_BATCH_SIZE frames at a time, and the shard latch is released while each batch is
+   * on its way to disk, so fetches keep being served during a checkpoint. Every page that is resident when the call
+   * starts and stays resident is written at least once; pages brought in while the flush runs may be skipped.
    */
   void FlushAllPages();
 
+  /**
+   * @brief Start a background thread that writes back dirty, unpinned pages before they have to be evicted.
+   *
+   * Whenever the fraction of dirty frames in a shard is above dirty_ratio_target, the flusher cleans the next
+   * FLUSH_BATCH_SIZE dirty frames in eviction order, so that a fetch rarely has to wait for the write back of its
+   * victim. It only looks at the FLUSH_SCAN_FRAMES frames closest to eviction, so in a larger shard the dirty frames
+   * further back stay dirty until evictions bring them closer.
+   * Calling this again replaces the settings of the running flusher.
+   *
+   * @param dirty_ratio_target fraction of the frames of a shard that may stay dirty, between 0 and 1
+   * @param interval how long the flusher sleeps when every shard is below the target
+   */
+  void StartBackgroundFlusher(double dirty_ratio_target,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** @brief Stop the background flusher, if it is running. */
+  void StopBackgroundFlusher();
+
+  /** @brief Return the number of dirty frames in the buffer pool. */
+  auto GetDirtyCount() -> size_t;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -185,20 +265,84 @@ class BufferPoolManager {
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUKReplacer> replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * One partition of the buffer pool. A shard owns a contiguous range of pages_ and frame ids are local to it.
+   */
+  struct BufferPoolShard {
+    BufferPoolShard(Page *pages, size_t pool_size, size_t replacer_k);
+
+    /** First frame owned by this shard. */
+    Page *pages_;
+    /** Number of frames owned by this shard. */
+    size_t pool_size_;
+    /** Memory holding the data of the shard's frames, or nullptr if each frame has its own heap allocation. */
+    std::unique_ptr<FrameArena> arena_;
+    /** Page table for keeping track of the pages in this shard. */
+    std::unordered_map<page_id_t, frame_id_t> page_table_;
+    /** Replacer to find unpinned pages for replacement. */
+    std::unique_ptr<LRUKReplacer> replacer_;
+    /** List of free frames that don't have any pages on them. */
+    std::list<frame_id_t> free_list_;
+    /**
+     * This latch protects page_table_, free_list_, io_in_progress_ and the book-keeping fields of every frame of the
+     * shard. It is never held across a disk read or write.
+     */
+    std::mutex latch_;
+    /**
+     * True while a frame is being written back or read in with latch_ released. While it is set, the frame may be
+     * reachable from the page table under both its old and its new page id, and nobody but the thread doing the I/O
+     * may touch its data.
+     */
+    std::vector<bool> io_in_progress_;
+    /** Per-frame condition signalled when the frame's io_in_progress_ flag is cleared. */
+    std::vector<std::condition_variable> io_cv_;
+    /** Number of frames of this shard whose page is dirty. Protected by latch_. */
+    size_t dirty_count_{0};
+    /** Number of fetches that found their page in this shard, indexed by AccessType. Protected by latch_. */
+    std::array<uint64_t, NUM_ACCESS_TYPES> hit_count_{};
+    /** Number of fetches that had to bring their page into this shard, indexed by AccessType. Protected by latch_. */
+    std::array<uint64_t, NUM_ACCESS_TYPES> miss_count_{};
+  };
+
+  /** The shards of the pool, indexed by page id modulo the number of shards. */
+  std::vector<std::unique_ptr<BufferPoolShard>> shards_;
+  /** Page ids that were skipped by AllocatePage(), indexed by their shard. Protected by page_id_latch_. */
+  std::vector<std::vector<page_id_t>> unused_page_ids_;
+  /** Taken after a shard latch, and never together with another latch otherwise. */
+  std::mutex page_id_latch_;
+
+  /** Background threads serving prefetch requests. They are started by the first prefetch request. */
+  std::vector<std::thread> prefetch_threads_;
+  std::once_flag prefetch_threads_started_;
+  /** Pending prefetch requests, protected by prefetch_latch_. */
+  std::deque<std::function<void()>> prefetch_tasks_;
+  bool prefetch_stop_{false};
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+
+  /** Background thread writing back dirty pages ahead of eviction, see StartBackgroundFlusher(). */
+  std::thread flusher_thread_;
+  /** Settings of the flusher and its stop flag, protected by flusher_latch_. */
+  double flusher_dirty_ratio_target_{0};
+  std::chrono::milliseconds flusher_interval_{0};
+  bool flusher_stop_{false};
+  std::mutex flusher_latch_;
+  std::condition_variable flusher_cv_;
+
+  /** @brief Return the shard that page_id is cached in. */
+  auto GetShard(page_id_t page_id) -> BufferPoolShard & {
+    return *shards_[static_cast<size_t>(page_id) % shards_.size()];
+  }
+
+  /**
+   * @brief Allocate a page on disk whose id maps to the given shard. Caller should hold the latch of that shard, and
+   * have checked that it has a frame for the page, so that the id is not lost.
+   *
+   * Ids that are skipped on the way to one for this shard are kept for their own shards, so that every id is used.
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(size_t shard_index) -> page_id_t;
 
   /**
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
@@ -208,10 +352,67 @@ class BufferPoolManager {
     // This is a no-nop right now without a more complex data structure to track deallocated pages
   }
 
-  // TODO(student): You may add additional private members and helper functions
-  auto GetAvailablePageAndInit(const std::function<page_id_t()> &page_id_generator,
-                               AccessType access_type = AccessType::Unknown) -> Page *;
+  /** @brief Pin a resident frame and record the access. Caller must hold the shard's latch. */
+  auto PinFrame(BufferPoolShard &shard, frame_id_t frame_id, AccessType access_type) -> Page *;
+
+  /**
+   * @brief Look up page_id in the page table, waiting out any I/O in progress on the frame that holds it.
+   * Caller must hold the shard's latch through lock; the lock may be released and re-acquired while waiting.
+   * @return the frame holding page_id, or std::nullopt if the page is not resident
+   */
+  auto FindFrame(BufferPoolShard &shard, page_id_t page_id, std::unique_lock<std::mutex> &lock)
+      -> std::optional<frame_id_t>;
+
+  /**
+   * @brief Take a frame from the free list or the replacer, pin it for page_id and bring it in.
+   *
+   * The frame is reserved and marked as I/O in progress under the shard latch, then the latch is dropped while the
+   * previous occupant is written back (if dirty) and, when read_page is set, while page_id is read from disk. Threads
+   * that look up either page in the meantime wait on the frame's condition. Caller must hold the latch through lock.
+   *
+   * @return the pinned page, or nullptr if every frame of the shard is pinned
+   */
+  auto GetAvailablePageAndInit(BufferPoolShard &shard, page_id_t page_id, bool read_page,
+                               std::unique_lock<std::mutex> &lock, AccessType access_type = AccessType::Unknown)
+      -> Page *;
+
+  /**
+   * @brief Write page_id back to disk through WriteBackFrames(), so that the shard latch is not held during the write.
+   * Caller must hold the latch through lock, and must not hold the page's latch.
+   * @return false if the page is not in the buffer pool
+   */
+  auto FlushPageInternal(BufferPoolShard &shard, page_id_t page_id, std::unique_lock<std::mutex> &lock) -> bool;
+
+  /** @brief Set the dirty flag of a resident page and keep the dirty count in sync. Caller must hold the latch. */
+  void SetDirty(BufferPoolShard &shard, Page *page, bool is_dirty);
 
-  auto FlushPageInternal(page_id_t page_id) -> bool;
+  /**
+   * @brief Write the pages held by the given frames to disk as one batch, sorted by page id.
+   *
+   * The frames are pinned and marked clean under the shard latch, then the latch is released. Each page is copied
+   * under its read latch, one page at a time so that no two page latches are ever held together, and the copies are
+   * handed to DiskManager::WritePages(). A page modified during the write is dirtied again by its writer's unpin.
+   * Frames that are free or have I/O in progress are skipped. Caller must hold the latch through lock, which is held
+   * again on return.
+   */
+  void WriteBackFrames(BufferPoolShard &shard, const std::vector<frame_id_t> &frame_ids,
+                       std::unique_lock<std::mutex> &lock);
+
+  /** @brief Main loop of the background flusher. */
+  void FlusherWorker();
+
+  /** @brief Queue a prefetch request for the background I/O threads, starting them if needed. */
+  void SubmitPrefetch(std::function<void()> task);
+
+  /** @brief Main loop of a background I/O thread. */
+  void PrefetchWorker();
+
+  /**
+   * @brief Bring page_id into its shard unless it is already there. Accesses are recorded as AccessType::Scan and do
+   * not count towards the hit and miss statistics.
+   * @param keep_pinned whether to return the page pinned, so that its data can be read
+   * @return the page (pinned only if keep_pinned), or nullptr if it is not cached and no frame could be freed for it
+   */
+  auto PrefetchPage(page_id_t page_id, bool keep_pinned) -> Page *;
 };
 }  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Where the memory of a frame arena is placed on a NUMA machine. */
+enum class NumaPolicy {
+  /** Leave placement to the kernel (first touch). */
+  Default,
+  /** Spread the arena page by page over all nodes. */
+  Interleave,
+  /** Place each shard of the buffer pool on one node, round robin over the nodes. */
+  BindShards
+};
+
+/** Options for backing the buffer pool frames with a FrameArena. */
+struct FrameArenaOptions {
+  /** Back the frames with 2 MiB huge pages to cut TLB misses on large pools. */
+  bool huge_pages_{true};
+  /** NUMA placement of the frames. Ignored on machines with a single node. */
+  NumaPolicy numa_policy_{NumaPolicy::Default};
+};
+
+/**
+ * FrameArena is one contiguous, anonymous memory mapping holding the data of a range of buffer pool frames.
+ *
+ * Frames are laid out back to back, and the first one is aligned to BUSTUB_PAGE_SIZE, so every frame can be handed to
+ * an O_DIRECT disk manager without staging. With huge pages, the arena is first mapped with MAP_HUGETLB; if no huge
+ * pages are reserved it falls back to a 2 MiB-aligned mapping advised with MADV_HUGEPAGE, so that transparent huge
+ * pages can back it. The NUMA policy is applied with mbind() before the memory is touched.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Map an arena.
+   * @param num_frames number of frames in the arena
+   * @param huge_pages whether to back the arena with 2 MiB huge pages
+   * @param numa_policy NUMA placement of the arena; BindShards binds the whole arena to numa_node
+   * @param numa_node node to bind to when numa_policy is BindShards
+   */
+  FrameArena(size_t num_frames, bool huge_pages, NumaPolicy numa_policy, int numa_node);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of the given frame */
+  auto GetFrame(size_t frame_id) -> char * { return data_ + frame_id * BUSTUB_PAGE_SIZE; }
+
+  /** @return true if the arena is backed by reserved (MAP_HUGETLB) huge pages */
+  auto IsHugeTlb() const -> bool { return huge_tlb_; }
+
+  /** @return the number of NUMA nodes of this machine, 1 if it cannot be determined */
+  static auto NumNumaNodes() -> int;
+
+ private:
+  /** Start and length of the whole mapping, including any alignment slack. */
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  /** First frame, and the length of the page-aligned region that holds the frames. */
+  char *data_{nullptr};
+  size_t data_size_{0};
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -13,9 +13,9 @@
 #pragma once
 
 #include <limits>
-#include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include "common/config.h"
@@ -24,21 +24,31 @@
 namespace bustub {
 
 enum class AccessType { Unknown = 0, Get, Scan };
+static constexpr size_t NUM_ACCESS_TYPES = 3;
 
 class LRUKNode {
   friend class LRUKReplacer;
 
  public:
-  explicit LRUKNode(frame_id_t fid) : fid_(fid) {}
+  LRUKNode() = default;
 
  private:
-  /** History of last seen K timestamps of this page. Least recent timestamp stored in front. */
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
-
-  std::list<size_t> history_;
-  [[maybe_unused]] size_t k_;
-  [[maybe_unused]] frame_id_t fid_;
+  /** Set that holds the node while it is evictable: frames with fewer than k accesses or with at least k. */
+  using EvictionSet = std::set<std::pair<size_t, frame_id_t>>;
+
+  /** Number of timestamps recorded in the node's history ring, at most k. */
+  size_t history_size_{0};
+  /** Ring index of the least recent timestamp still in the history. */
+  size_t history_head_{0};
+  bool is_tracked_{false};
   bool is_evictable_{false};
+  /** True while every access to the frame has been a sequential scan. */
+  bool is_scan_{false};
+  /**
+   * The node's entry in an EvictionSet while the frame is not evictable. It is extracted from the set and inserted
+   * back instead of being reallocated, so moving a frame in and out of the eviction order never touches the heap.
+   */
+  EvictionSet::node_type handle_;
 };
 
 /**
@@ -51,6 +61,15 @@ class LRUKNode {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multipe frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Evictable frames are kept ordered by the least recent timestamp in their history, in one set for frames with
+ * fewer than k accesses and one for the rest, so eviction only looks at the front of a set. Access histories live in
+ * a ring buffer of k slots per frame that is allocated once up front.
+ *
+ * Frames brought in by a sequential scan (AccessType::Scan) are kept in a third set that is evicted before any other
+ * frame, so a large scan recycles a handful of frames instead of flushing the working set. Scan accesses to a frame
+ * that was already used by other accesses do not change its position, and the first non-scan access turns a scan
+ * frame into a regular one.
  */
 class LRUKReplacer {
  public:
@@ -100,8 +119,8 @@ class LRUKReplacer {
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
    * @param frame_id id of frame that received a new access.
-   * @param access_type type of access that was received. This parameter is only needed for
-   * leaderboard tests.
+   * @param access_type type of access that was received. Scan accesses are placed at the cold end of the
+   * eviction order.
    */
   void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
 
@@ -152,10 +171,38 @@ class LRUKReplacer {
    */
   auto Size() -> size_t;
 
+  /**
+   * @brief Peek at the frames that would be evicted next, without evicting them.
+   *
+   * The buffer pool uses this to write back dirty pages before they reach the eviction point.
+   *
+   * @param max_frames maximum number of frames to return
+   * @return up to max_frames evictable frames, in the order Evict() would pick them
+   */
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t>;
+
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  std::unordered_map<frame_id_t, LRUKNode> node_store_;
+  /** @return the least recent timestamp in the frame's history, which orders it within its eviction set. */
+  auto EvictionKey(frame_id_t frame_id) -> std::pair<size_t, frame_id_t>;
+  /** @return the eviction set the frame belongs to according to its number of recorded accesses. */
+  auto EvictionSetOf(frame_id_t frame_id) -> LRUKNode::EvictionSet &;
+  /** Insert an evictable frame into its eviction set. */
+  void Link(frame_id_t frame_id);
+  /** Take a frame out of its eviction set, keeping the set node for later reuse. */
+  void Unlink(frame_id_t frame_id);
+  /** Drop the frame's access history and stop tracking it. */
+  void Reset(frame_id_t frame_id);
+
+  /** Per-frame book-keeping, indexed by frame id. */
+  std::vector<LRUKNode> node_store_;
+  /** History rings of all frames, k slots per frame. */
+  std::vector<size_t> history_;
+  /** Evictable frames only ever touched by scans. They are evicted first, least recently scanned first. */
+  LRUKNode::EvictionSet scan_frames_;
+  /** Evictable frames with fewer than k accesses (+inf backward k-distance), earliest first access first. */
+  LRUKNode::EvictionSet cold_frames_;
+  /** Evictable frames with k accesses, largest backward k-distance first. */
+  LRUKNode::EvictionSet hot_frames_;
   size_t current_timestamp_{0};
   size_t curr_size_{0};
   size_t replacer_size_;
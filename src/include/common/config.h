@@ -31,11 +31,22 @@ static constexpr int INVALID_PAGE_ID = -1;
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+#ifndef BUSTUB_PAGE_SIZE_BYTES
+#define BUSTUB_PAGE_SIZE_BYTES 4096  // set by the BUSTUB_PAGE_SIZE CMake option
+#endif
+
+static constexpr int BUSTUB_PAGE_SIZE = BUSTUB_PAGE_SIZE_BYTES;                      // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int PREFETCH_THREADS = 2;  // number of background threads serving buffer pool prefetches
+static constexpr int READ_AHEAD_PAGES = 8;  // number of pages sequential scans read ahead of the cursor
+static constexpr int FLUSH_BATCH_SIZE = 32;  // number of frames written back to disk as one batch
+static constexpr int FLUSH_SCAN_FRAMES = 8 * FLUSH_BATCH_SIZE;  // frames nearest eviction the flusher checks per pass
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;  // fraction of each B+ tree node filled by a bulk load
+static constexpr int TABLE_INSERT_PAGES = 8;  // number of pages a table heap lets threads insert into at the same time
+static constexpr int PAX_VARCHAR_SIZE_ESTIMATE = 16;  // bytes a varchar is expected to take when sizing PAX pages
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -44,6 +55,15 @@ using lsn_t = int32_t;         // log sequence number type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
+// O_DIRECT needs buffers, file offsets and lengths aligned to the logical block size of the device, 512 B to 4 KiB.
+// DiskManagerDirect aligns all three to the page size, so a page of at least 4 KiB suits any device. Table pages
+// address tuples with 15-bit offsets, as they keep a flag in the top bit, which caps the page size at 32 KiB.
+static_assert(BUSTUB_PAGE_SIZE >= 4096 && BUSTUB_PAGE_SIZE <= 32768, "page size must be between 4 KiB and 32 KiB");
+static_assert((BUSTUB_PAGE_SIZE & (BUSTUB_PAGE_SIZE - 1)) == 0, "page size must be a power of two");
+
 static constexpr int VARCHAR_DEFAULT_LENGTH = 128;  // default length for varchar when constructing the column
 
+/** How a table heap lays out tuples in its pages: one after another, or column by column (PAX). */
+enum class TableStorage : uint8_t { Row, Pax };
+
 }  // namespace bustub
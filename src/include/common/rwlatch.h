@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>  // NOLINT
 #include <shared_mutex>
 
@@ -21,18 +23,30 @@ namespace bustub {
 
 /**
  * Reader-Writer latch backed by std::mutex.
+ *
+ * The latch also keeps a version counter that is odd while the write latch is held and is bumped on every acquire and
+ * release of the write latch. Readers that can tolerate a retry may skip the read latch: take GetVersion(), read the
+ * protected data, and accept what they read only if ValidateVersion() succeeds.
  */
 class ReaderWriterLatch {
  public:
   /**
    * Acquire a write latch.
    */
-  void WLock() { mutex_.lock(); }
+  void WLock() {
+    mutex_.lock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Keep the writes to the protected data from being reordered before the version bump.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /**
    * Release a write latch.
    */
-  void WUnlock() { mutex_.unlock(); }
+  void WUnlock() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    mutex_.unlock();
+  }
 
   /**
    * Acquire a read latch.
@@ -46,8 +60,25 @@ class ReaderWriterLatch {
 
   auto TryRLock() -> bool { return mutex_.try_lock_shared(); }
 
+  /**
+   * Start an optimistic read.
+   * @return the current version, odd if a writer holds the latch (in which case the read is bound to fail validation)
+   */
+  auto GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+  /**
+   * Finish an optimistic read.
+   * @return true if no writer has held the latch since GetVersion() returned version
+   */
+  auto ValidateVersion(uint64_t version) const -> bool {
+    // Keep the reads of the protected data from being reordered after the version check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 && version_.load(std::memory_order_relaxed) == version;
+  }
+
  private:
   std::shared_mutex mutex_;
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
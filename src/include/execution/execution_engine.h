@@ -95,10 +95,11 @@ class ExecutionEngine {
   static void PollExecutor(AbstractExecutor *executor, const AbstractPlanNodeRef &plan,
                            std::vector<Tuple> *result_set) {
     RID rid{};
-    Tuple tuple{};
-    while (executor->Next(&tuple, &rid)) {
+    TupleRef tuple{};
+    // Rows are only copied out here, at the boundary to the client.
+    while (executor->NextRef(&tuple, &rid)) {
       if (result_set != nullptr) {
-        result_set->push_back(tuple);
+        result_set->emplace_back(tuple);
       }
     }
   }
@@ -47,6 +47,22 @@ class AbstractExecutor {
    */
   virtual auto Next(Tuple *tuple, RID *rid) -> bool = 0;
 
+  /**
+   * Yield the next tuple from this executor as a view, without copying it.
+   * The view stays valid until the next call to Init(), Next() or NextRef() on this executor. Executors that can hand
+   * out their tuples in place override this; by default the tuple is produced by Next() into a buffer.
+   * @param[out] tuple A view of the next tuple produced by this executor
+   * @param[out] rid The next tuple RID produced by this executor
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  virtual auto NextRef(TupleRef *tuple, RID *rid) -> bool {
+    if (!Next(&next_ref_buffer_, rid)) {
+      return false;
+    }
+    *tuple = next_ref_buffer_;
+    return true;
+  }
+
   /** @return The schema of the tuples that this executor produces */
   virtual auto GetOutputSchema() const -> const Schema & = 0;
 
@@ -54,7 +70,21 @@ class AbstractExecutor {
   auto GetExecutorContext() -> ExecutorContext * { return exec_ctx_; }
 
  protected:
+  /** Implement Next() for an executor that overrides NextRef(), by copying out the tuple it hands out. */
+  auto NextFromRef(Tuple *tuple, RID *rid) -> bool {
+    TupleRef tuple_ref;
+    if (!NextRef(&tuple_ref, rid)) {
+      return false;
+    }
+    *tuple = tuple_ref;
+    return true;
+  }
+
   /** The executor context in which the executor runs */
   ExecutorContext *exec_ctx_;
+
+ private:
+  /** Where the default NextRef() keeps the tuple it hands out. */
+  Tuple next_ref_buffer_;
 };
 }  // namespace bustub
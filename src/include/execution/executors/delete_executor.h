@@ -62,7 +62,8 @@ class DeleteExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_;
   std::vector<IndexInfo *> index_infos_;
-  void DeleteTuple(Tuple *tuple, RID rid);
-  bool is_end_;
+  void DeleteTuple(const TupleRef *tuple, RID rid);
+  /** Whether Next() has deleted the tuples and emitted their count; false until then, so the first call does it. */
+  bool is_end_ = false;
 };
 }  // namespace bustub
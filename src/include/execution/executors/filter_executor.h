@@ -48,6 +48,14 @@ class FilterExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Yield the next tuple from the filter as a view, without copying it.
+   * @param[out] tuple A view of the next tuple produced by the filter
+   * @param[out] rid The next tuple RID produced by the filter
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto NextRef(TupleRef *tuple, RID *rid) -> bool override;
+
   /** @return The output schema for the filter plan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
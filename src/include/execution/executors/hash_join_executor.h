@@ -95,12 +95,12 @@ class HashJoinExecutor : public AbstractExecutor {
   /** @return The output schema for the join */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
-  auto GetLeftJoinKey(const Tuple *tuple) -> JoinKey;
+  auto GetLeftJoinKey(const TupleRef *tuple) -> JoinKey;
 
-  auto GetRightJoinKey(const Tuple *tuple) -> JoinKey;
+  auto GetRightJoinKey(const TupleRef *tuple) -> JoinKey;
 
  private:
-  auto GetJoinKeys(const Tuple *tuple, const Schema &schema,
+  auto GetJoinKeys(const TupleRef *tuple, const Schema &schema,
                    const std::vector<AbstractExpressionRef> &expressions) const -> std::vector<Value>;
   void GetNextLeftTuple();
 
@@ -111,7 +111,8 @@ class HashJoinExecutor : public AbstractExecutor {
   std::unordered_map<JoinKey, std::vector<Tuple>> ht_;
   std::vector<Tuple>::iterator right_iter_;
   std::optional<std::vector<Tuple>::iterator> right_end_opt_{std::nullopt};
-  Tuple left_tuple_;
+  /** The current left tuple, a view that stays valid until the left child is asked for the next one. */
+  TupleRef left_tuple_;
   bool left_end_{false};
   bool last_left_match_{false};
 };
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 
 #include "common/rid.h"
@@ -46,6 +47,10 @@ class IndexScanExecutor : public AbstractExecutor {
   const IndexScanPlanNode *plan_;
   TableInfo *table_info_;
   IndexInfo *index_info_;
-  BPlusTreeIndexIteratorForTwoIntegerColumn index_iter_;
+  /** Fills in the RIDs of the next leaf in the range, see ScanLeaves(); false once the range is exhausted. */
+  std::function<bool(std::vector<RID> *)> next_leaf_;
+  /** The RIDs of the current leaf, and how many of them have been handed out. */
+  std::vector<RID> rids_;
+  size_t rid_index_{0};
 };
 }  // namespace bustub
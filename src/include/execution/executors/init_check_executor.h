@@ -46,6 +46,14 @@ class InitCheckExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Yield the next tuple from the child executor as a view, without copying it.
+   * @param[out] tuple A view of the next tuple produced by the child executor
+   * @param[out] rid The next tuple RID produced by the child executor
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto NextRef(TupleRef *tuple, RID *rid) -> bool override;
+
   /** @return The output schema for the child executor */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
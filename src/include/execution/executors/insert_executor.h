@@ -61,7 +61,7 @@ class InsertExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_;
   std::vector<IndexInfo *> index_infos_;
-  auto InsertTupleAndIndices(Tuple &tuple, Transaction *txn) -> bool;
+  auto InsertTupleAndIndices(const TupleRef &tuple, Transaction *txn) -> bool;
   bool is_end_ = false;
 };
 
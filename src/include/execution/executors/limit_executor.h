@@ -45,6 +45,14 @@ class LimitExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Yield the next tuple from the limit as a view, without copying it.
+   * @param[out] tuple A view of the next tuple produced by the limit
+   * @param[out] rid The next tuple RID produced by the limit
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto NextRef(TupleRef *tuple, RID *rid) -> bool override;
+
   /** @return The output schema for the limit */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
@@ -62,7 +62,8 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> right_executor_;
   bool left_end_{false};
   bool last_left_match_{false};
-  Tuple left_tuple_;
+  /** The current left tuple, a view that stays valid until the left child is asked for the next one. */
+  TupleRef left_tuple_;
 };
 
 }  // namespace bustub
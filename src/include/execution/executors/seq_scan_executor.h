@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "execution/executor_context.h"
@@ -45,6 +46,14 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /**
+   * Yield the next tuple from the sequential scan as a view, without copying it.
+   * @param[out] tuple A view of the next tuple produced by the sequential scan
+   * @param[out] rid The next tuple RID produced by the sequential scan
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto NextRef(TupleRef *tuple, RID *rid) -> bool override;
+
   /** @return The output schema for the sequential scan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
@@ -52,5 +61,8 @@ class SeqScanExecutor : public AbstractExecutor {
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   std::unique_ptr<TableIterator> iter_;
+  /** The tuples of the page being scanned, and the next one to look at. */
+  std::vector<std::pair<TupleMeta, TupleRef>> batch_;
+  size_t batch_index_{0};
 };
 }  // namespace bustub
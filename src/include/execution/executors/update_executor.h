@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -65,6 +66,8 @@ class UpdateExecutor : public AbstractExecutor {
   std::vector<IndexInfo *> index_infos_;
   /** The child executor to obtain value from */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The tuples this update has written, under their RIDs after the update. */
+  std::unordered_set<RID> updated_rids_;
   bool is_end_ = false;
 };
 }  // namespace bustub
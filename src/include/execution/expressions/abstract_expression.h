@@ -52,7 +52,7 @@ class AbstractExpression {
   virtual ~AbstractExpression() = default;
 
   /** @return The value obtained by evaluating the tuple with the given schema */
-  virtual auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value = 0;
+  virtual auto Evaluate(const TupleRef *tuple, const Schema &schema) const -> Value = 0;
 
   /**
    * Returns the value obtained by evaluating a JOIN.
@@ -62,7 +62,7 @@ class AbstractExpression {
    * @param right_schema The right tuple's schema
    * @return The value obtained by evaluating a JOIN on the left and right
    */
-  virtual auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
+  virtual auto EvaluateJoin(const TupleRef *left_tuple, const Schema &left_schema, const TupleRef *right_tuple,
                             const Schema &right_schema) const -> Value = 0;
 
   /** @return the child_idx'th child of this expression */
@@ -12,14 +12,33 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <utility>
 
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "type/value.h"
 
 namespace bustub {
+
+/** Bounds on the key of a single-column index. A missing bound leaves that end of the scan open. */
+struct IndexScanRange {
+  std::optional<Value> lower_{std::nullopt};
+  bool lower_inclusive_{true};
+  std::optional<Value> upper_{std::nullopt};
+  bool upper_inclusive_{true};
+
+  /** @return true if the range covers the whole index */
+  auto IsFull() const -> bool { return !lower_.has_value() && !upper_.has_value(); }
+
+  auto ToString() const -> std::string {
+    return fmt::format("{}{}, {}{}", lower_inclusive_ ? "[" : "(", lower_.has_value() ? lower_->ToString() : "-inf",
+                       upper_.has_value() ? upper_->ToString() : "+inf", upper_inclusive_ ? "]" : ")");
+  }
+};
+
 /**
  * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
  */
@@ -29,25 +48,40 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param range the keys to scan
+   * @param reverse whether to scan the keys in descending order
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, IndexScanRange range = {}, bool reverse = false)
+      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid), range_(std::move(range)), reverse_(reverse) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the identifier of the table that should be scanned */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return the keys to scan */
+  auto GetRange() const -> const IndexScanRange & { return range_; }
+
+  /** @return whether the keys are scanned in descending order */
+  auto IsReverse() const -> bool { return reverse_; }
+
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(IndexScanPlanNode);
 
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
-  // Add anything you want here for index lookup
+  /** The keys to scan. */
+  IndexScanRange range_;
+
+  /** Whether the keys are scanned in descending order. */
+  bool reverse_;
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    if (range_.IsFull() && !reverse_) {
+      return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    }
+    return fmt::format("IndexScan {{ index_oid={}, range={}, reverse={} }}", index_oid_, range_.ToString(), reverse_);
   }
 };
 
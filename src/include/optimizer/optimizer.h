@@ -85,6 +85,12 @@ class Optimizer {
    */
   auto OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize filter + seq scan as filter + index range scan if the filter bounds a column that has a
+   * single-column index. The filter is kept, as only the bounds on the indexed column are pushed into the scan.
+   */
+  auto OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /** @brief check if the index can be matched */
   auto MatchIndex(const std::string &table_name, uint32_t index_key_idx)
       -> std::optional<std::tuple<index_oid_t, std::string>>;
@@ -94,6 +100,17 @@ class Optimizer {
    */
   auto OptimizeSortLimitAsTopN(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief record on the sequential scans of PAX tables which of their columns the plan above them uses, so that the
+   * scans only read those
+   */
+  auto OptimizePruneScanColumns(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief prune the scans below a plan node, of whose output only the columns set in used are needed
+   */
+  auto PruneScanColumns(const AbstractPlanNodeRef &plan, std::vector<bool> used) -> AbstractPlanNodeRef;
+
   /**
    * @brief get the estimated cardinality for a table based on the table name. Useful when join reordering. BusTub
    * doesn't support statistics for now, so it's the only way for you to get the table size :(
@@ -13,10 +13,13 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 
@@ -42,7 +45,7 @@ class DiskManager {
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
@@ -51,6 +54,13 @@ class DiskManager {
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Write a batch of pages to the database file. Disk managers that can submit several writes at once override this;
+   * by default the pages are written one at a time.
+   * @param pages ids and raw data of the pages to write
+   */
+  virtual void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -72,16 +82,16 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
 
   /** @return the number of disk flushes */
-  auto GetNumFlushes() const -> int;
+  auto GetNumFlushes() const -> int64_t;
 
   /** @return true iff the in-memory content has not been flushed yet */
   auto GetFlushState() const -> bool;
 
   /** @return the number of disk writes */
-  auto GetNumWrites() const -> int;
+  auto GetNumWrites() const -> int64_t;
 
   /**
    * Sets the future which is used to check for non-blocking flushes.
@@ -93,15 +103,24 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  /**
+   * Open (or create) the log file that belongs to file_name_.
+   * @return false if file_name_ has no extension to derive the log file name from
+   */
+  auto OpenLogFile() -> bool;
+  auto GetFileSize(const std::string &file_name) -> int64_t;
+  /** @return the byte offset of a page in the database file */
+  static auto PageOffset(page_id_t page_id) -> int64_t { return static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE; }
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
-  int num_flushes_{0};
-  int num_writes_{0};
+  // Size of the database file in bytes. Kept up to date by WritePage so that reads don't need to stat the file.
+  int64_t db_file_size_{0};
+  int64_t num_flushes_{0};
+  std::atomic<int64_t> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
   // With multiple buffer pool instances, need to protect file access
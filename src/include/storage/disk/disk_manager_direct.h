@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_direct.h
+//
+// Identification: src/include/storage/disk/disk_manager_direct.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerDirect reads and writes database pages with pread/pwrite on a file descriptor opened with O_DIRECT,
+ * bypassing the OS page cache. Unlike DiskManager, it does not serialize page I/O: reads and writes of different pages
+ * proceed concurrently. Page buffers that are not aligned to BUSTUB_PAGE_SIZE are staged through an aligned per-thread
+ * buffer, as O_DIRECT requires. The log file is handled exactly as in DiskManager.
+ */
+class DiskManagerDirect : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io whether to bypass the page cache. Falls back to buffered I/O if the file system rejects O_DIRECT.
+   */
+  explicit DiskManagerDirect(const std::string &db_file, bool direct_io = true);
+
+  ~DiskManagerDirect() override;
+
+  /**
+   * Shut down the disk manager and close all the file resources.
+   */
+  void ShutDown() override;
+
+  /**
+   * Write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Write a batch of pages to the database file. Pages are written in page id order and runs of consecutive pages are
+   * submitted with a single pwritev call.
+   * @param pages ids and raw data of the pages to write
+   */
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) override;
+
+  /**
+   * Read a page from the database file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** @return true if the database file is accessed with O_DIRECT */
+  auto IsDirectIO() const -> bool { return direct_io_; }
+
+ private:
+  /** Write a run of pages with consecutive ids starting at first_page_id. */
+  void WriteRun(page_id_t first_page_id, const std::vector<const char *> &run);
+
+  int db_fd_{-1};
+  bool direct_io_;
+};
+
+}  // namespace bustub
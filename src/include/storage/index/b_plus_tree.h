@@ -3,7 +3,7 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, unless the tree is built non-unique: then equal keys are told apart by their values
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
@@ -11,13 +11,19 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <iostream>
+#include <mutex>  // NOLINT
 #include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/config.h"
@@ -60,6 +66,40 @@ class Context {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/**
+ * Statistics and integrity report of a B+ tree, see BPlusTree::Analyze(). Levels are numbered from the root down.
+ */
+template <typename KeyType>
+struct BPlusTreeStats {
+  /** Number of levels, 0 for an empty tree. */
+  int height_{0};
+  /** Pages on each level. */
+  std::vector<size_t> pages_;
+  /** Entries (keys of leaves, children of internal pages) on each level. */
+  std::vector<size_t> entries_;
+  /** Entries each level has room for, the sum of the max sizes of its pages. */
+  std::vector<size_t> capacity_;
+  /** Non-root pages below their minimum size, which lazy removes leave until they are compacted. */
+  size_t underfull_pages_{0};
+  /** Leaves whose next leaf is not the page with the following page id, i.e. where a scan cannot read sequentially. */
+  size_t leaf_chain_breaks_{0};
+  /** Equi-depth histogram of the keys: each bucket holds the number of keys from its lower bound to the next one's. */
+  std::vector<std::pair<KeyType, size_t>> histogram_;
+  /**
+   * Whether no insert or remove ran during the walk. Integrity violations are only reported for a quiescent tree, as
+   * those seen while it changes may just be pages caught halfway through a split or merge.
+   */
+  bool is_quiescent_{true};
+  /** Number of integrity violations found, of which the first few are described in errors_. */
+  size_t num_errors_{0};
+  std::vector<std::string> errors_;
+
+  /** @return the fraction of the entries that level has room for in use */
+  auto FillFactor(int level) const -> double {
+    return capacity_[level] == 0 ? 0.0 : static_cast<double>(entries_[level]) / capacity_[level];
+  }
+};
+
 enum class ModificationType { INSERT = 0, DELETE };
 
 // Main class providing the API for the Interactive B+ Tree.
@@ -68,21 +108,62 @@ class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
+  // Reverse scans descend the tree again to step from one leaf to the one on its left.
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
+
  public:
+  /**
+   * @param unique whether keys are unique. A non-unique tree stores the value in the last bytes of each key
+   * (GenericKey::SetRid()), so entries are ordered by key and then value, and are still unique within the tree.
+   * The key columns must therefore leave room for the value.
+   */
   explicit BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator, int leaf_max_size = LEAF_PAGE_SIZE,
-                     int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int internal_max_size = INTERNAL_PAGE_SIZE, bool unique = true);
+
+  ~BPlusTree();
+
+  DISALLOW_COPY_AND_MOVE(BPlusTree);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert a key-value pair into this B+ tree. Returns false if the key (with this value, if non-unique) exists.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *txn = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and its value from this (unique) B+ tree.
   void Remove(const KeyType &key, Transaction *txn);
 
-  // Return the value associated with a given key
+  // Remove a key-value pair from this B+ tree. A unique tree removes the key whatever its value.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *txn);
+
+  /**
+   * @brief Start a background thread that merges underfull leaves, and make removes lazy while it runs.
+   *
+   * A lazy remove only write-latches the leaf and takes the entry out of it, whatever size that leaves the leaf at.
+   * Leaves that fall below their minimum size are queued, and the compactor later merges or redistributes them under
+   * the usual write latches from an ancestor down, so foreground removes never restructure the tree. Until then,
+   * lookups and scans simply see smaller (possibly empty) leaves. A leaf is queued only once however often it is
+   * removed from, and while MAX_QUEUED_LEAVES leaves wait, removes rebalance as if the compactor did not run.
+   */
+  void StartBackgroundCompactor();
+
+  /** @brief Stop the background compactor, if it is running, after merging the leaves still queued. */
+  void StopBackgroundCompactor();
+
+  using BulkLoadIterator = typename std::vector<std::pair<KeyType, ValueType>>::const_iterator;
+
+  /**
+   * Build this (empty) B+ tree from key/value pairs sorted by key. Leaves are filled left to right and each internal
+   * level is built bottom-up from the one below it, so no node is ever split. Of several entries with the same key,
+   * only the first is loaded, as Insert() would reject the others. A non-unique tree needs its input sorted by key and
+   * then value, and only skips repeated key-value pairs.
+   * @param fill_factor fraction of each node to fill; nodes are never filled below their minimum size
+   * @return false if the tree is not empty
+   */
+  auto BulkLoad(BulkLoadIterator begin, BulkLoadIterator end, double fill_factor = BULK_LOAD_FILL_FACTOR) -> bool;
+
+  // Return the value associated with a given key, or all of them if the tree is non-unique
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
   // Return the page id of the root node
@@ -95,6 +176,25 @@ class BPlusTree {
 
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  /**
+   * Scan the keys within a range, in ascending order or, if reverse, in descending order.
+   * @return an iterator at the first key of the scan, which reaches End() once it passes the far bound. The keys of
+   * a non-unique tree come out as stored, with their value in the last bytes.
+   */
+  auto Scan(const KeyRange<KeyType> &range, bool reverse = false) -> INDEXITERATOR_TYPE;
+
+  /**
+   * @brief Walk the whole tree with read latches, num_threads subtrees at a time, and collect its statistics.
+   *
+   * Besides the shape of the tree, the walk checks that keys are ordered within and across pages, that all leaves
+   * are on the same level and that the leaf chain links them in key order. Only one page per thread is latched at a
+   * time, so writers are not held up, but then the walk may see a tree that changes under it. The integrity check is
+   * meant for a quiescent tree: if the tree was modified during the walk, is_quiescent_ is cleared and no violations
+   * are reported, while the statistics are still those of the pages as the walk found them.
+   * @param histogram_buckets number of histogram buckets; bucket bounds are the first keys of leaves
+   */
+  auto Analyze(int num_threads = 1, int histogram_buckets = 10) -> BPlusTreeStats<KeyType>;
+
   // Print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -121,6 +221,32 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *txn = nullptr);
 
  private:
+  /** What the walk of one subtree learned; the subtrees of Analyze() are walked in parallel and merged in order. */
+  struct SubtreeStats {
+    std::vector<size_t> pages_;
+    std::vector<size_t> entries_;
+    std::vector<size_t> capacity_;
+    size_t underfull_pages_{0};
+    /** Leaves in key order: page id, next page id, size and first key. */
+    std::vector<std::tuple<page_id_t, page_id_t, int, KeyType>> leaves_;
+    size_t num_errors_{0};
+    std::vector<std::string> errors_;
+    /** The level all leaves should be on. */
+    int leaf_level_{0};
+
+    void Report(std::string error);
+  };
+
+  /** A subtree still to be walked: its root page id and the bounds [lower, upper) of its keys. */
+  using SubtreeRoot = std::tuple<page_id_t, std::optional<KeyType>, std::optional<KeyType>>;
+
+  /**
+   * Walk the subtree rooted at the given level. If frontier is given, only its root page is checked and the
+   * subtrees of its children are appended to frontier instead of being walked.
+   */
+  void AnalyzeSubtree(const SubtreeRoot &subtree, int level, SubtreeStats *stats,
+                      std::vector<SubtreeRoot> *frontier = nullptr);
+
   /* Debug Routines for FREE!! */
   void ToGraph(page_id_t page_id, const BPlusTreePage *page, std::ofstream &out);
 
@@ -137,6 +263,14 @@ class BPlusTree {
   // Acquire and release write latches as searching downwards along the way
   auto FindLeafToModify(const KeyType &key, Context &ctx, ModificationType ops) -> page_id_t;
 
+  /**
+   * Descend with read latches and write-latch only the leaf, whose guard is left in ctx.write_set_. Inserts and
+   * removes that do not split or merge the leaf are done on this path without ever write-latching the header or any
+   * internal page; the others fall back to FindLeafToModify().
+   * @return the leaf page id, or INVALID_PAGE_ID if the tree is empty
+   */
+  auto FindLeafOptimistic(const KeyType &key, Context &ctx) -> page_id_t;
+
   void InsertToParent(page_id_t left_page_id, page_id_t right_page_id, const KeyType &key, Context &ctx);
 
   void SetRootPage(page_id_t root_page_id, Context &ctx);
@@ -144,6 +278,12 @@ class BPlusTree {
 
   void RemoveLeaf(page_id_t page_id, const KeyType &key, Context &ctx);
 
+  /**
+   * Merge or redistribute the leaf, whose guard is the last one in ctx.write_set_, if it is below its minimum size.
+   * @param key a key that leads to the leaf, used to find it among the children of its parent
+   */
+  void RebalanceLeaf(page_id_t page_id, const KeyType &key, Context &ctx);
+
   /**
    * remove the page.array_[entry_index]
    * @param parent_page_id
@@ -160,10 +300,57 @@ class BPlusTree {
    */
   auto GetSiblingPage(InternalPage *parent_page, const KeyType &key) -> std::tuple<page_id_t, bool, int>;
 
+  /** @return the key under which a non-unique tree stores key and value */
+  auto TreeKey(const KeyType &key, const ValueType &value) const -> KeyType;
+
+  /**
+   * Descend to the leaf without latching any page. Every page is read between a version check and a validation, and
+   * the parent is revalidated after its child is pinned, so the child cannot have been freed in between.
+   * @param[out] leaf_guard pins the leaf, which the caller must read under the same validation protocol
+   * @param[out] leaf_version version of the leaf when it was reached
+   * @return the leaf page id, INVALID_PAGE_ID if the tree is empty, or nullopt if a writer got in the way
+   */
+  auto TryFindLeafToRead(const KeyType &key, bool left_most, BasicPageGuard *leaf_guard, uint64_t *leaf_version)
+      -> std::optional<page_id_t>;
+
+  /**
+   * Find the leaf and leave its read guard in ctx.read_set_. The descent is optimistic (TryFindLeafToRead()) and
+   * only latches the leaf; after OPTIMISTIC_READ_ATTEMPTS failed descents it falls back to read-latch crabbing.
+   */
   auto FindLeafToRead(const KeyType &key, bool left_most, Context &ctx) -> page_id_t;
 
+  /**
+   * Find the last key < key (<= key if or_equal), or the last key of the tree if key is nullopt, with read-latch
+   * crabbing. The descent picks the child that would hold such a key; if that subtree turns out to have none left, the
+   * search is repeated below the separator of the deepest such child.
+   * @return the index of the key in the leaf whose read guard is left in ctx.read_set_, or -1 if there is no such key
+   */
+  auto FindLastBefore(const std::optional<KeyType> &key, bool or_equal, Context &ctx) const -> int;
+
+  /** Optimistic descents a lookup tries before it latches its way down the tree. */
+  static constexpr int OPTIMISTIC_READ_ATTEMPTS = 8;
+
+  /** Counts an insert or remove for as long as it runs, so that Analyze() can tell whether the tree was quiescent. */
+  struct ModificationGuard {
+    explicit ModificationGuard(BPlusTree *tree) : tree_(tree) {
+      tree_->active_modifications_++;
+      tree_->num_modifications_++;
+    }
+    ~ModificationGuard() { tree_->active_modifications_--; }
+    BPlusTree *tree_;
+  };
+
+  /** Leaves the compactor may have queued; past that, removes rebalance their leaves themselves again. */
+  static constexpr size_t MAX_QUEUED_LEAVES = 1024;
+
   void ReleaseAncestors(Context &ctx);
 
+  /** Rebalance the leaf that key leads to, if it is underfull. */
+  void CompactLeaf(const KeyType &key);
+
+  /** @brief Main loop of the background compactor. */
+  void CompactorWorker();
+
   // member variable
   std::string index_name_;
   BufferPoolManager *bpm_;
@@ -172,6 +359,25 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t header_page_id_;
+  bool unique_;
+
+  /** Inserts and removes running now, and ever started. See ModificationGuard. */
+  std::atomic<int> active_modifications_{0};
+  std::atomic<size_t> num_modifications_{0};
+
+  /** Whether removes are lazy, i.e. whether the background compactor runs. */
+  std::atomic<bool> lazy_remove_{false};
+  /** Background thread merging underfull leaves, see StartBackgroundCompactor(). */
+  std::thread compactor_thread_;
+  /**
+   * The leaves left underfull by lazy removes, each queued once, with the last key removed from it, which leads to it.
+   * Also the compactor's stop flag.
+   */
+  std::deque<page_id_t> compaction_queue_;
+  std::unordered_map<page_id_t, KeyType> underfull_pages_;
+  bool compactor_stop_{false};
+  std::mutex compactor_latch_;
+  std::condition_variable compactor_cv_;
 };
 
 /**
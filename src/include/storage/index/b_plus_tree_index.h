@@ -35,12 +35,24 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Fill an empty index with all its entries at once. The entries are sorted here and handed to BPlusTree::BulkLoad().
+   * @return false if the index is not empty
+   */
+  auto BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries, Transaction *transaction) -> bool;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  /** @return an iterator over the keys within range, walking them in descending order if reverse */
+  auto GetRangeIterator(const KeyRange<KeyType> &range, bool reverse) -> INDEXITERATOR_TYPE;
+
+  /** @return the statistics and integrity report of the tree, walked by num_threads threads (BPlusTree::Analyze()) */
+  auto Analyze(int num_threads) -> BPlusTreeStats<KeyType>;
+
  protected:
   // comparator for key
   KeyComparator comparator_;
@@ -48,7 +60,11 @@ class BPlusTreeIndex : public Index {
   std::shared_ptr<BPlusTree<KeyType, ValueType, KeyComparator>> container_;
 };
 
-/** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
+/**
+ * We only support index table with one integer key for now in BusTub. Hardcode everything here. The key holds up to
+ * two integer columns. A non-unique index follows them with the RID that it orders equal keys by, so its keys take
+ * twice the room: its pages hold half as many of them, and its lookups cannot use the AVX2 rank of 8-byte keys.
+ */
 
 constexpr static const auto TWO_INTEGER_SIZE = 8;
 using IntegerKeyType = GenericKey<TWO_INTEGER_SIZE>;
@@ -59,4 +75,11 @@ using BPlusTreeIndexIteratorForTwoIntegerColumn =
     IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
 using IntegerHashFunctionType = HashFunction<IntegerKeyType>;
 
+constexpr static const auto TWO_INTEGER_RID_SIZE = 16;
+using NonUniqueIntegerKeyType = GenericKey<TWO_INTEGER_RID_SIZE>;
+using NonUniqueIntegerComparatorType = GenericComparator<TWO_INTEGER_RID_SIZE>;
+using NonUniqueBPlusTreeIndexForTwoIntegerColumn =
+    BPlusTreeIndex<NonUniqueIntegerKeyType, IntegerValueType, NonUniqueIntegerComparatorType>;
+using NonUniqueIntegerHashFunctionType = HashFunction<NonUniqueIntegerKeyType>;
+
 }  // namespace bustub
@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <string>
+#include <type_traits>
 
+#include "common/macros.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -25,73 +29,235 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The columns of the key are stored one after the other in an order-preserving binary encoding, so that two keys
+ * compare like their bytes do and GenericComparator is a memcmp():
+ * - integers (and booleans) are big-endian with the sign bit flipped. The NULL of these types is their minimum value,
+ *   so NULLs sort first;
+ * - decimals are big-endian IEEE doubles, with the sign bit flipped for positive values and all bits flipped for
+ *   negative ones;
+ * - timestamps are big-endian (NULL is the maximum value and sorts last);
+ * - varchars are a 0x00 (NULL) or 0x01 marker followed by the characters, with every 0x00 escaped as 0x00 0xFF, and
+ *   a 0x00 0x00 terminator.
+ * The rest of the key is zero, except in non-unique B+ trees, which keep the RID in the last bytes (SetRid()). An
+ * encoding longer than KeySize is truncated, so keys that only differ past KeySize bytes compare equal.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t pos = 0;
+    for (uint32_t i = 0; i < key_schema.GetColumnCount() && pos < KeySize; i++) {
+      auto value = tuple.GetValue(&key_schema, i);
+      switch (value.GetTypeId()) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          pos = EncodeSigned(pos, value.GetAs<int8_t>());
+          break;
+        case TypeId::SMALLINT:
+          pos = EncodeSigned(pos, value.GetAs<int16_t>());
+          break;
+        case TypeId::INTEGER:
+          pos = EncodeSigned(pos, value.GetAs<int32_t>());
+          break;
+        case TypeId::BIGINT:
+          pos = EncodeSigned(pos, value.GetAs<int64_t>());
+          break;
+        case TypeId::DECIMAL: {
+          auto decimal = value.GetAs<double>();
+          uint64_t bits;
+          memcpy(&bits, &decimal, sizeof(bits));
+          pos = EncodeUnsigned(pos, (bits & SIGN_BIT<uint64_t>) != 0 ? ~bits : bits | SIGN_BIT<uint64_t>);
+          break;
+        }
+        case TypeId::TIMESTAMP:
+          pos = EncodeUnsigned(pos, value.GetAs<uint64_t>());
+          break;
+        case TypeId::VARCHAR:
+          pos = EncodeVarchar(pos, value);
+          break;
+        default:
+          UNREACHABLE("cannot index a column of this type");
+      }
+    }
+  }
+
+  /**
+   * Overwrite the last RID_SIZE bytes of the key with rid, so that equal keys of a non-unique B+ tree are told apart
+   * (and ordered) by their RID. Any key column encoded into those bytes is cut short.
+   */
+  inline void SetRid(const RID &rid) {
+    if constexpr (KeySize > RID_SIZE) {
+      EncodeUnsigned(EncodeSigned(KeySize - RID_SIZE, rid.GetPageId()), rid.GetSlotNum());
+    } else {
+      UNREACHABLE("the key has no room for a RID");
+    }
   }
 
   // NOTE: for test purpose only
+  // encode key as a single BIGINT column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    EncodeSigned(0, key);
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      pos = SkipColumn(pos, schema->GetColumn(i).GetType());
+    }
+    const TypeId column_type = schema->GetColumn(column_idx).GetType();
+    switch (column_type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        return {column_type, DecodeSigned<int8_t>(pos)};
+      case TypeId::SMALLINT:
+        return {column_type, DecodeSigned<int16_t>(pos)};
+      case TypeId::INTEGER:
+        return {column_type, DecodeSigned<int32_t>(pos)};
+      case TypeId::BIGINT:
+        return {column_type, DecodeSigned<int64_t>(pos)};
+      case TypeId::DECIMAL: {
+        auto bits = DecodeUnsigned<uint64_t>(pos);
+        bits = (bits & SIGN_BIT<uint64_t>) != 0 ? bits & ~SIGN_BIT<uint64_t> : ~bits;
+        double decimal;
+        memcpy(&decimal, &bits, sizeof(decimal));
+        return {column_type, decimal};
+      }
+      case TypeId::TIMESTAMP:
+        return {column_type, DecodeUnsigned<uint64_t>(pos)};
+      case TypeId::VARCHAR: {
+        if (pos >= KeySize || data_[pos] == 0) {
+          return Value(column_type);
+        }
+        std::string str;
+        for (pos++; pos < KeySize && !(data_[pos] == 0 && (pos + 1 == KeySize || data_[pos + 1] == 0)); pos++) {
+          str.push_back(data_[pos]);
+          pos += data_[pos] == 0 ? 1 : 0;
+        }
+        return {column_type, str};
+      }
+      default:
+        UNREACHABLE("cannot index a column of this type");
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the key as a single BIGINT column
+  inline auto ToString() const -> int64_t { return DecodeSigned<int64_t>(0); }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // interpret the key as a single BIGINT column
   friend auto operator<<(std::ostream &os, const GenericKey &key) -> std::ostream & {
     os << key.ToString();
     return os;
   }
 
+  /** Bytes of an encoded RID, see SetRid(). */
+  static constexpr size_t RID_SIZE = sizeof(page_id_t) + sizeof(uint32_t);
+
   // actual location of data, extends past the end.
   char data_[KeySize];
+
+ private:
+  template <typename T>
+  static constexpr T SIGN_BIT = T{1} << (sizeof(T) * 8 - 1);
+
+  /** Write value big-endian at pos, cut short at the end of the key. @return the position after it */
+  template <typename T>
+  inline auto EncodeUnsigned(size_t pos, T value) -> size_t {
+    for (size_t i = 0; i < sizeof(T) && pos < KeySize; i++, pos++) {
+      data_[pos] = static_cast<char>(value >> ((sizeof(T) - 1 - i) * 8));
+    }
+    return pos;
+  }
+
+  template <typename T>
+  inline auto EncodeSigned(size_t pos, T value) -> size_t {
+    using U = std::make_unsigned_t<T>;
+    return EncodeUnsigned(pos, static_cast<U>(static_cast<U>(value) ^ SIGN_BIT<U>));
+  }
+
+  inline auto EncodeVarchar(size_t pos, const Value &value) -> size_t {
+    if (value.IsNull()) {
+      return pos + 1;
+    }
+    data_[pos++] = 1;
+    // The stored length counts a trailing '\0'.
+    const char *str = value.GetData();
+    uint32_t len = value.GetLength() > 0 ? value.GetLength() - 1 : 0;
+    for (uint32_t i = 0; i < len && pos < KeySize; i++) {
+      data_[pos++] = str[i];
+      if (str[i] == 0 && pos < KeySize) {
+        data_[pos++] = static_cast<char>(0xFF);
+      }
+    }
+    // The terminator is the zero fill.
+    return pos + 2;
+  }
+
+  template <typename T>
+  inline auto DecodeUnsigned(size_t pos) const -> T {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); i++, pos++) {
+      value = (value << 8) | (pos < KeySize ? static_cast<uint8_t>(data_[pos]) : 0);
+    }
+    return value;
+  }
+
+  template <typename T>
+  inline auto DecodeSigned(size_t pos) const -> T {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(DecodeUnsigned<U>(pos) ^ SIGN_BIT<U>);
+  }
+
+  inline auto SkipColumn(size_t pos, TypeId type) const -> size_t {
+    if (type != TypeId::VARCHAR) {
+      return pos + Type::GetTypeSize(type);
+    }
+    if (pos >= KeySize || data_[pos++] == 0) {
+      return pos;
+    }
+    while (pos < KeySize && !(data_[pos] == 0 && (pos + 1 == KeySize || data_[pos + 1] == 0))) {
+      pos += data_[pos] == 0 ? 2 : 1;
+    }
+    return pos + 2;
+  }
 };
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys are compared byte by byte (see GenericKey), without deserializing any column. The key schema is kept only so
+ * that the comparator can be built the same way as before.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
+    if constexpr (KeySize == sizeof(uint64_t) || KeySize == sizeof(uint32_t)) {
+      // The common one- and two-integer keys compare as a single big-endian word.
+      using Word = std::conditional_t<KeySize == sizeof(uint64_t), uint64_t, uint32_t>;
+      Word l;
+      Word r;
+      memcpy(&l, lhs.data_, KeySize);
+      memcpy(&r, rhs.data_, KeySize);
+      if constexpr (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) {
+        if constexpr (KeySize == sizeof(uint64_t)) {
+          l = __builtin_bswap64(l);
+          r = __builtin_bswap64(r);
+        } else {
+          l = __builtin_bswap32(l);
+          r = __builtin_bswap32(r);
+        }
       }
+      return l < r ? -1 : (l > r ? 1 : 0);
+    } else {
+      auto cmp = memcmp(lhs.data_, rhs.data_, KeySize);
+      return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
     }
-    // equals
-    return 0;
   }
 
   GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
@@ -100,7 +266,7 @@ class GenericComparator {
   explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
 
  private:
-  Schema *key_schema_;
+  [[maybe_unused]] Schema *key_schema_;
 };
 
 }  // namespace bustub
@@ -13,12 +13,26 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <optional>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
+/** Bounds of a range scan. A missing bound leaves that end of the range open. */
+template <typename KeyType>
+struct KeyRange {
+  std::optional<KeyType> lower_{std::nullopt};
+  bool lower_inclusive_{true};
+  std::optional<KeyType> upper_{std::nullopt};
+  bool upper_inclusive_{true};
+};
+
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
@@ -26,8 +40,15 @@ class IndexIterator {
  public:
   // you may define your own constructor based on your member variables
   IndexIterator();
-  IndexIterator(page_id_t page_id, int index, std::optional<ReadPageGuard> read_page_guard,
-                BufferPoolManager *buffer_pool_manager);
+  /**
+   * Start a scan at the given position of a read-latched leaf. A forward scan positioned past the end of its leaf moves
+   * on to the next leaf; a scan whose first key is already out of range starts at the end.
+   * @param range bounds of the scan; the iterator reaches the end at the first key past them
+   * @param reverse whether the scan walks towards smaller keys
+   */
+  IndexIterator(const BPlusTree<KeyType, ValueType, KeyComparator> *tree, page_id_t page_id, int index,
+                std::optional<ReadPageGuard> read_page_guard, BufferPoolManager *buffer_pool_manager,
+                KeyRange<KeyType> range = {}, bool reverse = false);
   IndexIterator(IndexIterator &&that) noexcept;
   auto operator=(IndexIterator &&that) noexcept -> IndexIterator &;
 
@@ -35,6 +56,9 @@ class IndexIterator {
 
   auto IsEnd() -> bool;
 
+  /** @return whether the current item is the last one of its leaf in the direction of the scan */
+  auto IsLastInLeaf() const -> bool;
+
   auto operator*() -> const MappingType &;
 
   auto operator++() -> IndexIterator &;
@@ -44,12 +68,25 @@ class IndexIterator {
   auto operator!=(const IndexIterator &itr) const -> bool { return page_id_ != itr.page_id_ || index_ != itr.index_; }
 
  private:
+  /** Move past the end of the current leaf if needed, then end the scan if the current key is out of range. */
+  void Settle();
+
+  void SetEnd();
+
   // add your own private member variables here
+  const BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+  KeyRange<KeyType> range_;
+  // Leaves only link to their right sibling, so a reverse scan finds each previous leaf by descending the tree again.
+  bool reverse_{false};
   page_id_t page_id_{INVALID_PAGE_ID};
   int index_{-1};
   std::optional<ReadPageGuard> page_guard_{std::nullopt};
-  BufferPoolManager *bpm_;
-  const LeafPage *page_;
+  BufferPoolManager *bpm_{nullptr};
+  const LeafPage *page_{nullptr};
+  // Leaf pages keep keys and values apart, so operator*() assembles the current item here.
+  MappingType item_;
+  // Number of leaves left to walk before the next read-ahead request is issued.
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
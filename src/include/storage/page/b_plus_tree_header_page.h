@@ -13,4 +13,6 @@ class BPlusTreeHeaderPage {
   page_id_t root_page_id_;
 };
 
+static_assert(sizeof(BPlusTreeHeaderPage) <= BUSTUB_PAGE_SIZE);
+
 }  // namespace bustub
@@ -19,7 +19,7 @@ namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
 #define INTERNAL_PAGE_HEADER_SIZE 12
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -29,9 +29,11 @@ namespace bustub {
  * should ignore the first key.
  *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ----------------------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | (free keys) | PAGE_ID(1) | PAGE_ID(2) | ... | PAGE_ID(n) |
+ *  ----------------------------------------------------------------------------------------------------------
+ *
+ * As in leaf pages, keys and child page ids are two arrays with room for INTERNAL_PAGE_SIZE entries each.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -93,9 +95,10 @@ class BPlusTreeInternalPage : public BPlusTreePage {
    *
    * @param key
    * @param comparator
+   * @param or_equal false to find the child holding the last key < input key instead
    * @return The index of last key s.t. <= input key
    */
-  auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> int;
+  auto Lookup(const KeyType &key, const KeyComparator &comparator, bool or_equal = true) const -> int;
 
   /**
    * @brief For test only, return a string representing all keys in
@@ -124,7 +127,12 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   }
 
  private:
-  // Flexible array member for page data.
-  MappingType array_[0];
+  auto ValueArray() -> ValueType * { return reinterpret_cast<ValueType *>(key_array_ + INTERNAL_PAGE_SIZE); }
+  auto ValueArray() const -> const ValueType * {
+    return reinterpret_cast<const ValueType *>(key_array_ + INTERNAL_PAGE_SIZE);
+  }
+
+  // Flexible array member for page data: INTERNAL_PAGE_SIZE keys, followed by as many child page ids.
+  KeyType key_array_[0];
 };
 }  // namespace bustub
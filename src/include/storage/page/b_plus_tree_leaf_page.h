@@ -20,7 +20,7 @@ namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
 #define LEAF_PAGE_HEADER_SIZE 16
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
@@ -28,9 +28,12 @@ namespace bustub {
  * page. Only support unique key.
  *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | (free keys) | RID(1) | RID(2) | ... | RID(n) |
+ *  ------------------------------------------------------------------------------------------
+ *
+ * Keys and RIDs are kept in two arrays, each with room for LEAF_PAGE_SIZE entries, so that a search only touches
+ * the cache lines of the keys.
  *
  *  Header format (size in byte, 16 bytes in total):
  *  ---------------------------------------------------------------------
@@ -58,7 +61,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
-  auto ItemAt(int index) const -> const MappingType &;
+  auto ItemAt(int index) const -> MappingType;
 
   /**
    *
@@ -67,6 +70,8 @@ class BPlusTreeLeafPage : public BPlusTreePage {
    * @return the index of first key >= given key; if equal, return true
    */
   auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> std::pair<int, bool>;
+  /** @return the number of keys < key, or <= key if or_equal */
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator, bool or_equal) const -> int;
   auto ValueAt(int index) const -> ValueType;
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> bool;
   auto Remove(const KeyType &key, const KeyComparator &comparator) -> bool;
@@ -103,8 +108,15 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   }
 
  private:
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+
+  auto ValueArray() -> ValueType * { return reinterpret_cast<ValueType *>(key_array_ + LEAF_PAGE_SIZE); }
+  auto ValueArray() const -> const ValueType * {
+    return reinterpret_cast<const ValueType *>(key_array_ + LEAF_PAGE_SIZE);
+  }
+
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[0];
+  // Flexible array member for page data: LEAF_PAGE_SIZE keys, followed by as many values.
+  KeyType key_array_[0];
 };
 }  // namespace bustub
@@ -63,4 +63,36 @@ class BPlusTreePage {
   int max_size_ __attribute__((__unused__));
 };
 
+/**
+ * Binary search over the sorted key array of a B+ tree page.
+ * @param keys the keys, in increasing order
+ * @param size the number of keys
+ * @param or_equal whether keys equal to key are counted
+ * @return the number of keys less than key (not greater than key, if or_equal), i.e. its lower (upper) bound
+ */
+template <typename KeyType, typename KeyComparator>
+auto KeyRank(const KeyType *keys, int size, const KeyType &key, const KeyComparator &comparator, bool or_equal)
+    -> int {
+  int left = 0;
+  int right = size;
+  while (left < right) {
+    int mid = (right - left) / 2 + left;
+    int cmp = comparator(keys[mid], key);
+    if (cmp < 0 || (or_equal && cmp == 0)) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+/**
+ * One- and two-integer keys rank the last few candidates with AVX2 compares instead of further probes, if the CPU
+ * supports it.
+ */
+template <>
+auto KeyRank(const GenericKey<8> *keys, int size, const GenericKey<8> &key, const GenericComparator<8> &comparator,
+             bool or_equal) -> int;
+
 }  // namespace bustub
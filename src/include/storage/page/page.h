@@ -37,7 +37,11 @@ class Page {
   }
 
   /** Default destructor. */
-  ~Page() { delete[] data_; }
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
@@ -65,6 +69,12 @@ class Page {
 
   inline auto TryRLatch() -> bool { return rwlatch_.TryRLock(); }
 
+  /** @return the version of the page latch, to start a read without latching the page */
+  inline auto GetVersion() const -> uint64_t { return rwlatch_.GetVersion(); }
+
+  /** @return true if the page has not been write-latched since GetVersion() returned version */
+  inline auto ValidateVersion(uint64_t version) const -> bool { return rwlatch_.ValidateVersion(version); }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -83,10 +93,22 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
+  /** Hold the page's data in memory owned by the caller, e.g. a buffer pool frame arena, instead of the heap. */
+  void AttachData(char *data) {
+    if (owns_data_) {
+      delete[] data_;
+    }
+    data_ = data;
+    owns_data_ = false;
+    ResetMemory();
+  }
+
   /** The actual data that is stored within a page. */
   // Usually this should be stored as `char data_[BUSTUB_PAGE_SIZE]{};`. But to enable ASAN to detect page overflow,
   // we store it as a ptr.
   char *data_;
+  /** False if data_ belongs to someone else, see AttachData(). */
+  bool owns_data_ = true;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
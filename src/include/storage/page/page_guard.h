@@ -78,6 +78,14 @@ class BasicPageGuard {
     return reinterpret_cast<T *>(GetDataMut());
   }
 
+  /**
+   * A basic guard only pins the page, so a concurrent writer may change it under the reader. Reads through a basic guard
+   * are taken between GetVersion() and a successful ValidateVersion(), and thrown away otherwise.
+   */
+  auto GetVersion() -> uint64_t { return page_->GetVersion(); }
+
+  auto ValidateVersion(uint64_t version) -> bool { return page_->ValidateVersion(version); }
+
  private:
   friend class ReadPageGuard;
   friend class WritePageGuard;
@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.h
+//
+// Identification: src/include/storage/page/pax_table_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+#include "type/type_id.h"
+#include "type/value.h"
+
+namespace bustub {
+
+static constexpr uint64_t PAX_TABLE_PAGE_HEADER_SIZE = 12;
+
+/**
+ * Where the columns of a table are kept in its PAX pages. It only depends on the schema, so all pages of a table
+ * share it.
+ *
+ * A page holds a fixed number of tuples, chosen so that a page is about full when its varchars take
+ * PAX_VARCHAR_SIZE_ESTIMATE bytes (or their declared length, if that is less). Pages with longer varchars run out of
+ * room for them before all slots are used.
+ */
+class PaxLayout {
+  friend class PaxTablePage;
+
+ public:
+  explicit PaxLayout(const Schema &schema);
+
+  /** @return the schema of the tuples */
+  auto GetSchema() const -> const Schema & { return schema_; }
+
+  /** @return the number of tuples a page holds at most */
+  auto GetCapacity() const -> uint16_t { return capacity_; }
+
+ private:
+  /** Where the null bitmap and the values of a column start in a page, and how many bytes each value takes there. */
+  struct ColumnInfo {
+    TypeId type_;
+    uint16_t null_bitmap_offset_;
+    uint16_t values_offset_;
+    uint16_t width_;
+  };
+
+  /** Lay the columns out for capacity tuples. @return where the last column ends */
+  auto LayOut(uint16_t capacity) -> size_t;
+
+  Schema schema_;
+  /** The fixed-length part of a tuple whose values are all null, which columns a scan does not read are left at. */
+  std::vector<char> null_tuple_;
+  uint16_t capacity_{0};
+  std::vector<ColumnInfo> columns_;
+  /** Where the last column ends; variable-length data is kept behind it, at the end of the page. */
+  uint16_t columns_end_{0};
+};
+
+/**
+ * PAX (partition attributes across) page format. A page holds the same tuples a slotted page would, but stores each
+ * column on its own, so that a scan only reads the columns it needs:
+ *  --------------------------------------------------------------------------------------
+ *  | HEADER | TupleMeta_1 ... TupleMeta_n | COLUMN_1 | ... | COLUMN_m | ... FREE SPACE ... | ... VARCHAR DATA ... |
+ *  --------------------------------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------
+ *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) | VarDataSize(2) | Capacity(2) |
+ *  ----------------------------------------------------------------------------
+ *
+ *  Column format, for a page that holds n tuples:
+ *  ------------------------------------------------------------
+ *  | null bitmap (n / 8, rounded up) | value_1 | ... | value_n |
+ *  ------------------------------------------------------------
+ *
+ * Fixed-length values are kept in the column itself. For a varchar, the column holds the offset of the value, which is
+ * stored as it would be in a tuple, and the values are packed at the end of the page. The null bitmap has a bit set for
+ * each tuple whose value is null; null values take no space besides their (unused) entry in the column.
+ *
+ * Tuples are only appended. Deleted tuples keep their space, so PAX pages are not vacuumed, and tuples cannot be
+ * updated in place.
+ */
+class PaxTablePage {
+ public:
+  /** Initialize the page header for the given layout. */
+  void Init(const PaxLayout &layout);
+
+  /** @return number of tuples in this page */
+  auto GetNumTuples() const -> uint32_t { return num_tuples_; }
+
+  /** @return number of tuples in this page that are deleted */
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
+  /** @return the page ID of the next table page */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /**
+   * Insert a tuple into the page.
+   * @param values the values of the tuple, one for each column of the layout
+   * @return the slot of the tuple, or std::nullopt if the page is full or has no room for its varchars
+   */
+  auto InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const std::vector<Value> &values)
+      -> std::optional<uint16_t>;
+
+  /**
+   * Update a tuple meta.
+   */
+  void UpdateTupleMeta(const TupleMeta &meta, const RID &rid);
+
+  /**
+   * Read a tuple meta from a table.
+   */
+  auto GetTupleMeta(const RID &rid) const -> TupleMeta;
+
+  /**
+   * Read a single value of a tuple, without touching the other columns.
+   */
+  auto GetValue(const PaxLayout &layout, uint16_t tuple_id, uint32_t column) const -> Value;
+
+  /**
+   * Read a tuple from a table, putting its row back together.
+   */
+  auto GetTuple(const PaxLayout &layout, const RID &rid) const -> std::pair<TupleMeta, Tuple>;
+
+  /**
+   * Put the rows of tuples begin up to end back together, stored back to back the way a Tuple stores its data. Only
+   * the given columns are copied out of the page, one column at a time; the others are null.
+   * @param columns the columns to read
+   * @param[out] data the rows
+   * @param[out] offsets where each row starts in data, followed by where the last one ends
+   */
+  void SerializeTuples(const PaxLayout &layout, uint16_t begin, uint16_t end, const std::vector<uint32_t> &columns,
+                       std::vector<char> *data, std::vector<uint32_t> *offsets) const;
+
+  static_assert(sizeof(page_id_t) == 4);
+
+ private:
+  /** @return a pointer to the entry of a value in its column */
+  auto ValueAt(const PaxLayout::ColumnInfo &column, uint16_t tuple_id) const -> const char * {
+    return page_start_ + column.values_offset_ + column.width_ * tuple_id;
+  }
+
+  /** @return whether a tuple has a null value in a column */
+  auto IsNull(const PaxLayout::ColumnInfo &column, uint16_t tuple_id) const -> bool {
+    return (page_start_[column.null_bitmap_offset_ + tuple_id / 8] & (1 << (tuple_id % 8))) != 0;
+  }
+
+  char page_start_[0];
+  page_id_t next_page_id_;
+  uint16_t num_tuples_;
+  uint16_t num_deleted_tuples_;
+  uint16_t var_data_size_;
+  uint16_t capacity_;
+  TupleMeta tuple_meta_[0];
+};
+
+static_assert(sizeof(PaxTablePage) == PAX_TABLE_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
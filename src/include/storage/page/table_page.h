@@ -13,6 +13,7 @@
 #pragma once
 
 #include <cstring>
+#include <limits>
 #include <optional>
 #include <tuple>
 #include <utility>
@@ -27,7 +28,7 @@
 
 namespace bustub {
 
-static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
+static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 12;
 
 /**
  * Slotted page format:
@@ -39,7 +40,7 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *
  *  Header format (size in bytes):
  *  ----------------------------------------------------------------------------
- *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) |
+ *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) | TupleDataSize(2) | NumFreeSlots(2) |
  *  ----------------------------------------------------------------------------
  *  ----------------------------------------------------------------
  *  | Tuple_1 offset+size (4) | Tuple_2 offset+size (4) | ... |
@@ -47,6 +48,16 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *
  * Tuple format:
  * | meta | data |
+ *
+ * The tuples take up the last TupleDataSize bytes of the page, which also counts deleted tuples until the page is
+ * vacuumed. Vacuuming packs the remaining tuples at the end of the page and frees the slots of the deleted ones, which
+ * later inserts reuse; a free slot has offset and size 0 and is marked deleted. NumTuples counts all slots.
+ *
+ * A tuple can be updated in place, whatever its new size. When it grows and there is no room behind the other tuples,
+ * the page is compacted first, which also reclaims the holes earlier updates left. A tuple that does not fit into its
+ * page at all is moved to another one: its slot then forwards to the tuple's new RID, and keeps its meta, while the
+ * moved tuple is skipped by scans. Pages are at most 32 KiB, so the top bit of a slot's offset marks a forwarding
+ * slot, and the top bit of its size a moved tuple.
  */
 
 class TablePage {
@@ -59,21 +70,35 @@ class TablePage {
   /** @return number of tuples in this page */
   auto GetNumTuples() const -> uint32_t { return num_tuples_; }
 
+  /** @return number of tuples in this page that are deleted but still take up space */
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
+  /** @return the number of bytes between the slots and the tuples, room for a new tuple and possibly its slot */
+  auto GetFreeSpace() const -> uint32_t {
+    return BUSTUB_PAGE_SIZE - tuple_data_size_ - TABLE_PAGE_HEADER_SIZE - TUPLE_INFO_SIZE * num_tuples_;
+  }
+
   /** @return the page ID of the next table page */
   auto GetNextPageId() const -> page_id_t { return next_page_id_; }
 
   /** Set the page id of the next page in the table. */
   void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
-  /** Get the next offset to insert, return nullopt if this tuple cannot fit in this page */
-  auto GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
+  /**
+   * Get the next offset to insert, return nullopt if this tuple cannot fit in this page
+   * @param reuse_free_slot whether the tuple may take a free slot, or needs a new one after all others
+   */
+  auto GetNextTupleOffset(const TupleMeta &meta, const TupleRef &tuple, bool reuse_free_slot = true) const
+      -> std::optional<uint16_t>;
 
   /**
    * Insert a tuple into the table.
    * @param tuple tuple to insert
+   * @param reuse_free_slot whether the tuple may take a free slot, or needs a new one after all others
    * @return true if the insert is successful (i.e. there is enough space)
    */
-  auto InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t>;
+  auto InsertTuple(const TupleMeta &meta, const TupleRef &tuple, bool reuse_free_slot = true)
+      -> std::optional<uint16_t>;
 
   /**
    * Update a tuple.
@@ -85,6 +110,11 @@ class TablePage {
    */
   auto GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from a table without copying it. The view points into this page.
+   */
+  auto GetTupleRef(const RID &rid) const -> std::pair<TupleMeta, TupleRef>;
+
   /**
    * Read a tuple meta from a table.
    */
@@ -95,14 +125,81 @@ class TablePage {
    */
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
+  /**
+   * Replace a tuple, compacting the page if it needs the room. A forwarding slot holds the tuple itself afterwards.
+   * @param tuple the new tuple, which must not point into this page
+   * @return false if the tuple does not fit into the page, which is then left as it was
+   */
+  auto UpdateTupleInPlace(const TupleMeta &meta, const TupleRef &tuple, const RID &rid) -> bool;
+
+  /**
+   * Make a slot forward to the RID a tuple was moved to, dropping the tuple the slot held.
+   * @return false if there is no room for the forwarding address, in which case the slot is left as it was
+   */
+  auto SetForward(const TupleMeta &meta, const RID &rid, const RID &target) -> bool;
+
+  /** @return the RID the slot forwards to, or std::nullopt if it holds a tuple of its own */
+  auto GetForward(const RID &rid) const -> std::optional<RID>;
+
+  /** Mark a tuple as moved here from a forwarding slot, so that scans skip it. */
+  void SetMoved(const RID &rid);
+
+  /** @return whether the tuple was moved here from a forwarding slot */
+  auto IsMoved(const RID &rid) const -> bool { return (std::get<1>(tuple_info_[rid.GetSlotNum()]) & SLOT_FLAG) != 0; }
+
+  /** @return whether the slot was freed by vacuuming, so that it holds no tuple until an insert reuses it */
+  auto IsFree(const RID &rid) const -> bool { return IsFreeSlot(rid.GetSlotNum()); }
+
+  /**
+   * Remove the deleted tuples from the page and free their slots. The other tuples keep their slots.
+   * @return the number of tuples removed
+   */
+  auto Vacuum() -> uint32_t;
+
+  /** The number of bytes a tuple of the given size takes up in a page, including a slot for it. */
+  static constexpr auto SpaceFor(uint32_t tuple_size) -> size_t { return tuple_size + TUPLE_INFO_SIZE; }
+
   static_assert(sizeof(page_id_t) == 4);
 
  private:
   using TupleInfo = std::tuple<uint16_t, uint16_t, TupleMeta>;
+
+  /** Marks a forwarding slot in the offset of a slot, and a moved tuple in its size. */
+  static constexpr uint16_t SLOT_FLAG = 0x8000;
+
+  /** @return where the data of a slot starts */
+  auto GetOffset(uint16_t tuple_id) const -> uint16_t { return std::get<0>(tuple_info_[tuple_id]) & ~SLOT_FLAG; }
+
+  /** @return how many bytes of data a slot has */
+  auto GetSize(uint16_t tuple_id) const -> uint16_t { return std::get<1>(tuple_info_[tuple_id]) & ~SLOT_FLAG; }
+
+  /** Point a slot to other data, keeping its flags. */
+  void SetData(uint16_t tuple_id, uint16_t offset, uint16_t size) {
+    auto &[slot_offset, slot_size, meta] = tuple_info_[tuple_id];
+    slot_offset = (slot_offset & SLOT_FLAG) | offset;
+    slot_size = (slot_size & SLOT_FLAG) | size;
+  }
+
+  /**
+   * Store data for a slot, dropping the data it had. Without room behind the other tuples, the page is compacted.
+   * @return false if the data does not fit into the page, which is then left as it was
+   */
+  auto PutData(uint16_t tuple_id, const char *data, uint16_t size) -> bool;
+
+  /** Pack the data of all slots at the end of the page, closing the holes between them. */
+  void Compact();
+
+  /** @return whether the slot was freed by vacuuming and holds no tuple */
+  auto IsFreeSlot(uint16_t tuple_id) const -> bool {
+    return std::get<0>(tuple_info_[tuple_id]) == 0 && std::get<2>(tuple_info_[tuple_id]).is_deleted_;
+  }
+
   char page_start_[0];
   page_id_t next_page_id_;
   uint16_t num_tuples_;
   uint16_t num_deleted_tuples_;
+  uint16_t tuple_data_size_;
+  uint16_t num_free_slots_;
   TupleInfo tuple_info_[0];
 
   static constexpr size_t TUPLE_INFO_SIZE = 16;
@@ -110,5 +207,6 @@ class TablePage {
 };
 
 static_assert(sizeof(TablePage) == TABLE_PAGE_HEADER_SIZE);
+static_assert(BUSTUB_PAGE_SIZE <= std::numeric_limits<uint16_t>::max() / 2 + 1, "tuple offsets must fit in 15 bits");
 
 }  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap keeps track of how many bytes are free in the pages of a table heap, so that inserts can reuse the
+ * space that vacuuming reclaims instead of always appending to the last page.
+ *
+ * The numbers are approximate: they are only refreshed when the heap writes to a page, so a page may have gained or
+ * lost room since it was recorded. Whoever picks a page from the map has to check that the tuple really fits, and
+ * record what it found. FreeSpaceMap is not thread-safe.
+ */
+class FreeSpaceMap {
+ public:
+  /** Record that page_id has free_space bytes free. Pages without free space are forgotten. */
+  void Update(page_id_t page_id, size_t free_space);
+
+  /** Forget about page_id. */
+  void Remove(page_id_t page_id);
+
+  /**
+   * Find a page for a tuple. Of the pages that fit it, the one with the least free space is chosen, so that the
+   * larger holes are left for larger tuples.
+   * @param size the number of bytes needed
+   * @return a page with at least size bytes free, or std::nullopt if there is none
+   */
+  auto FindPage(size_t size) const -> std::optional<page_id_t>;
+
+  /** @return the number of pages with free space */
+  auto GetNumPages() const -> size_t { return free_space_.size(); }
+
+ private:
+  std::unordered_map<page_id_t, size_t> free_space_;
+  /** The same pages, ordered by free space. */
+  std::set<std::pair<size_t, page_id_t>> pages_by_free_space_;
+};
+
+}  // namespace bustub
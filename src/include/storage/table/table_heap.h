@@ -12,24 +12,50 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>  // NOLINT
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
+#include "storage/page/pax_table_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+/** What a vacuum pass over a table heap found and did. */
+struct TableVacuumStats {
+  size_t pages_{0};
+  size_t pages_vacuumed_{0};
+  size_t tuples_removed_{0};
+  size_t free_bytes_{0};
+};
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * Deleted tuples are removed from a page once they make up a good share of it, or by Vacuum(), and a free space map
+ * records where room is left. Inserts go to a page from that map when there is one. Otherwise, each thread inserts
+ * into one of several insert pages, picked by its thread id, so that threads inserting at the same time mostly latch
+ * different pages; when an insert page fills up, a new page is appended to the heap and takes its place.
+ *
+ * While an iterator that stops at the end of the table as it was when the scan began is open, inserts only go to
+ * pages appended after it began, as the scan would otherwise see tuples that it is not meant to, e.g. those an update
+ * inserts. An insert page that the scan may still reach is swapped for a new page, so threads keep inserting into
+ * pages of their own.
+ *
+ * A table heap can also keep its tuples in PAX pages, which store them column by column (see PaxTablePage), so that
+ * scans that only need a few columns do not read the others. PAX pages never have room freed in them: they are not
+ * vacuumed, and their tuples are not updated in place.
  */
 class TableHeap {
   friend class TableIterator;
@@ -40,9 +66,18 @@ class TableHeap {
   /**
    * Create a table heap without a transaction. (open table)
    * @param buffer_pool_manager the buffer pool manager
-   * @param first_page_id the id of the first page
+   * @param num_insert_pages the number of pages that threads insert into at the same time
+   */
+  explicit TableHeap(BufferPoolManager *bpm, size_t num_insert_pages = TABLE_INSERT_PAGES);
+
+  /**
+   * Create a table heap whose pages are laid out in the given format.
+   * @param schema the schema of the tuples, which PAX pages need to split them into columns
+   * @param storage the format of the pages
+   * @param num_insert_pages the number of pages that threads insert into at the same time
    */
-  explicit TableHeap(BufferPoolManager *bpm);
+  TableHeap(BufferPoolManager *bpm, const Schema &schema, TableStorage storage,
+            size_t num_insert_pages = TABLE_INSERT_PAGES);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
@@ -50,7 +85,7 @@ class TableHeap {
    * @param tuple tuple to insert
    * @return rid of the inserted tuple
    */
-  auto InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr = nullptr,
+  auto InsertTuple(const TupleMeta &meta, const TupleRef &tuple, LockManager *lock_mgr = nullptr,
                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::optional<RID>;
 
   /**
@@ -63,9 +98,10 @@ class TableHeap {
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
+   * @param access_type how the page is being accessed, AccessType::Scan for sequential scans
    * @return the meta and tuple
    */
-  auto GetTuple(RID rid) -> std::pair<TupleMeta, Tuple>;
+  auto GetTuple(RID rid, AccessType access_type = AccessType::Unknown) -> std::pair<TupleMeta, Tuple>;
 
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` insead
@@ -75,8 +111,12 @@ class TableHeap {
    */
   auto GetTupleMeta(RID rid) -> TupleMeta;
 
-  /** @return the iterator of this table, use this for project 3 */
-  auto MakeIterator() -> TableIterator;
+  /**
+   * @param columns the columns that a scan of a PAX table reads, or all if empty. The others are null in the tuples
+   * it returns. Tuples of other tables are always read whole.
+   * @return the iterator of this table, use this for project 3
+   */
+  auto MakeIterator(std::vector<uint32_t> columns = {}) -> TableIterator;
 
   /** @return the iterator of this table, use this for project 4 except updates */
   auto MakeEagerIterator() -> TableIterator;
@@ -84,6 +124,28 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the format of the pages of this table */
+  inline auto GetStorage() const -> TableStorage {
+    return pax_layout_ == std::nullopt ? TableStorage::Row : TableStorage::Pax;
+  }
+
+  /**
+   * Remove the deleted tuples from all pages of the table, and record the space that is left in the free space map.
+   * @return what the pass found and did
+   */
+  auto Vacuum() -> TableVacuumStats;
+
+  /**
+   * Update a tuple, keeping its RID. The tuple stays in its page if it fits there, after compacting the page if need
+   * be. Otherwise it is moved to another page and its slot forwards to it; reads and scans follow the forward.
+   * @param meta new tuple meta
+   * @param tuple new tuple
+   * @param rid the rid of the tuple to be updated
+   * @return false if the slot has no room left even for a forwarding address, or the table is kept in PAX pages, in
+   * which case the tuple is unchanged
+   */
+  auto UpdateTuple(const TupleMeta &meta, const TupleRef &tuple, RID rid) -> bool;
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
@@ -93,11 +155,74 @@ class TableHeap {
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
  private:
+  /** A page is vacuumed as soon as at least 1 / VACUUM_DELETED_FRACTION of its tuples are deleted. */
+  static constexpr uint32_t VACUUM_DELETED_FRACTION = 2;
+
+  /** Let inserts know that a bounded scan is open, or no longer is. Called by TableIterator. */
+  void BeginScan();
+  void EndScan();
+
+  /** A page that inserts go to, shared by the threads whose ids map to it. */
+  struct InsertPage {
+    std::mutex latch_;
+    page_id_t page_id_;      /* protected by latch_ */
+    size_t page_number_{0}; /* position of the page in the heap, protected by latch_ */
+  };
+
+  /** Create the first page of the heap. */
+  void CreateFirstPage();
+
+  /** Initialize a new page of the heap in its format. */
+  void InitPage(char *page_data) const;
+
+  /** @return the number of slots of a page of the heap */
+  auto GetNumTuples(const char *page_data) const -> uint32_t;
+
+  /** @return the page after a page of the heap */
+  auto GetNextPageId(const char *page_data) const -> page_id_t;
+
+  /**
+   * Insert into the page page_guard holds, in the format of the heap.
+   * @return the slot of the tuple, or std::nullopt if it does not fit
+   */
+  auto InsertIntoPage(WritePageGuard *page_guard, const TupleMeta &meta, const TupleRef &tuple, bool reuse_free_slot)
+      -> std::optional<uint16_t>;
+
+  /** Insert a tuple where InsertTuple() would. page_guard holds its page afterwards. */
+  auto Insert(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard) -> RID;
+
+  /** Insert into a page from the free space map. On success, page_guard holds the page. */
+  auto InsertIntoFreeSpace(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard)
+      -> std::optional<RID>;
+
+  /**
+   * Insert into the insert page of the calling thread. page_guard holds the page afterwards.
+   * @param after_scans whether the tuple must go to a page appended after all open scans began, which they never reach
+   */
+  auto InsertIntoInsertPage(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard, bool after_scans)
+      -> RID;
+
+  /** Append a new page to the heap and return it write latched. latch_ must be held. */
+  auto AppendPage() -> WritePageGuard;
+
+  /** Remove the deleted tuples from a page that is write latched by page_guard, and release it. */
+  void VacuumPage(WritePageGuard page_guard, TableVacuumStats *stats);
+
   BufferPoolManager *bpm_;
   page_id_t first_page_id_{INVALID_PAGE_ID};
 
+  // Latch order: an insert page latch, then latch_, then page latches. free_space_latch_ is taken alone.
   std::mutex latch_;
   page_id_t last_page_id_{INVALID_PAGE_ID}; /* protected by latch_ */
+  std::vector<InsertPage> insert_pages_;
+  std::mutex free_space_latch_;
+  FreeSpaceMap free_space_map_; /* protected by free_space_latch_ */
+  std::atomic<size_t> num_pages_{1}; /* written under latch_ */
+  std::atomic<size_t> num_open_scans_{0};
+  /** The position of the first page appended after the last bounded scan began. */
+  std::atomic<size_t> first_page_after_scans_{0};
+  /** Where the columns are kept in the pages, for a heap of PAX pages. */
+  std::optional<PaxLayout> pax_layout_;
 };
 
 }  // namespace bustub
@@ -15,6 +15,7 @@
 #include <cassert>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rid.h"
@@ -26,7 +27,12 @@ namespace bustub {
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * TableIterator enables the sequential scan of a TableHeap. It reads the heap a page at a time: each page is pinned
+ * once, copied into a buffer of the iterator, and released before its tuples are handed out as views into that
+ * buffer. Tuples are therefore seen as they were when the scan reached their page.
+ *
+ * The rows of a PAX page are put back together from the columns the scan reads, one column at a time, straight into
+ * a buffer of the iterator.
  */
 class TableIterator {
   friend class Cursor;
@@ -34,10 +40,13 @@ class TableIterator {
  public:
   DISALLOW_COPY(TableIterator);
 
-  TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid);
-  TableIterator(TableIterator &&) = default;
+  /**
+   * @param columns the columns to read from PAX pages, or all if empty; the others are null in the tuples handed out
+   */
+  TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid, std::vector<uint32_t> columns = {});
+  TableIterator(TableIterator &&other) noexcept;
 
-  ~TableIterator() = default;
+  ~TableIterator();
 
   auto GetTuple() -> std::pair<TupleMeta, Tuple>;
 
@@ -47,7 +56,23 @@ class TableIterator {
 
   auto operator++() -> TableIterator &;
 
+  /**
+   * Hand out the tuples of the current page that the iterator has not moved past yet, and move it to the next page.
+   * The views stay valid until the next call to NextBatch().
+   * @return the tuples with their metadata, empty once the iterator is at the end
+   */
+  auto NextBatch() -> std::vector<std::pair<TupleMeta, TupleRef>>;
+
  private:
+  /** Load the tuples from rid on, skipping pages that have none left for the scan, or move to the end. */
+  void LoadPage(RID rid);
+
+  /** Put the rows of the PAX page in page_ back together, from slot begin up to slot end. */
+  void LoadPaxTuples(page_id_t page_id, uint32_t begin, uint32_t end);
+
+  /** Ask the buffer pool to read ahead along the page chain that starts at page_id. */
+  void ReadAhead(page_id_t page_id);
+
   TableHeap *table_heap_;
   RID rid_;
 
@@ -55,6 +80,29 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+  // Whether the table heap has been told about this scan, so that it does not insert tuples the scan would see.
+  bool is_registered_{false};
+
+  // The columns to read from PAX pages, all if empty.
+  std::vector<uint32_t> columns_;
+
+  // The tuples of the current page, from rid_ on, and where the scan continues once they are used up. They point into
+  // page_, into owned_ for tuples that were moved to other pages, or into rows_ for the rows of PAX pages, which start
+  // at row_offsets_; the page handed out by the last NextBatch() is kept in batch_page_, batch_owned_ and batch_rows_
+  // while the caller reads it.
+  std::vector<char> page_;
+  std::vector<char> batch_page_;
+  std::vector<Tuple> owned_;
+  std::vector<Tuple> batch_owned_;
+  std::vector<char> rows_;
+  std::vector<char> batch_rows_;
+  std::vector<uint32_t> row_offsets_;
+  std::vector<std::pair<TupleMeta, TupleRef>> batch_;
+  size_t batch_index_{0};
+  RID next_rid_;
+
+  // Number of pages left to scan before the next read-ahead request is issued.
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
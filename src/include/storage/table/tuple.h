@@ -42,59 +42,45 @@ struct TupleMeta {
 
 static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 
+class Tuple;
+
 /**
+ * TupleRef is a read-only view of a tuple whose bytes live elsewhere: in a page, in a buffer of an executor, or in a
+ * Tuple. It never owns them, so it must not be used after they are gone; whoever hands one out says for how long it
+ * stays valid. Copying a TupleRef is cheap and only copies the view.
+ *
  * Tuple format:
  * ---------------------------------------------------------------------
  * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
  * ---------------------------------------------------------------------
  */
-class Tuple {
-  friend class TablePage;
-  friend class TableHeap;
-  friend class TableIterator;
-
+class TupleRef {
  public:
-  // Default constructor (to create a dummy tuple)
-  Tuple() = default;
-
-  // constructor for table heap tuple
-  explicit Tuple(RID rid) : rid_(rid) {}
-
-  // constructor for creating a new tuple based on input value
-  Tuple(std::vector<Value> values, const Schema *schema);
-
-  Tuple(const Tuple &other) = default;
-
-  // move constructor
-  Tuple(Tuple &&other) noexcept = default;
-
-  // assign operator, deep copy
-  auto operator=(const Tuple &other) -> Tuple & = default;
+  // Default constructor (to create an empty view)
+  TupleRef() = default;
 
-  // move assignment
-  auto operator=(Tuple &&other) noexcept -> Tuple & = default;
+  // constructor for a view of length bytes at data
+  TupleRef(const char *data, uint32_t length, RID rid) : data_(data), length_(length), rid_(rid) {}
 
   // serialize tuple data
   void SerializeTo(char *storage) const;
 
-  // deserialize tuple data(deep copy)
-  void DeserializeFrom(const char *storage);
-
   // return RID of current tuple
   inline auto GetRid() const -> RID { return rid_; }
 
-  // Get the address of this tuple in the table's backing store
-  inline auto GetData() const -> const char * { return data_.data(); }
+  // Get the address of this tuple's bytes
+  inline auto GetData() const -> const char * { return data_; }
 
   // Get length of the tuple, including varchar legth
-  inline auto GetLength() const -> uint32_t { return data_.size(); }
+  inline auto GetLength() const -> uint32_t { return length_; }
 
   // Get the value of a specified column (const)
   // checks the schema to see how to return the Value.
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
   // Generates a key tuple given schemas and attributes
-  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
 
   // Is the column value null ?
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
@@ -104,12 +90,65 @@ class Tuple {
 
   auto ToString(const Schema *schema) const -> std::string;
 
- private:
+ protected:
   // Get the starting storage address of specific column
   auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
 
+  const char *data_{nullptr};
+  uint32_t length_{0};
   RID rid_{};  // if pointing to the table heap, the rid is valid
-  std::vector<char> data_;
+};
+
+/**
+ * Tuple is a TupleRef that owns its bytes, so it can be used wherever a view is expected. Copying a Tuple, or
+ * constructing or assigning one from a TupleRef, copies the bytes.
+ */
+class Tuple : public TupleRef {
+  friend class TablePage;
+  friend class PaxTablePage;
+  friend class TableHeap;
+  friend class TableIterator;
+
+ public:
+  // Default constructor (to create a dummy tuple)
+  Tuple() = default;
+
+  // constructor for table heap tuple
+  explicit Tuple(RID rid) : TupleRef(nullptr, 0, rid) {}
+
+  // constructor for creating a new tuple based on input value
+  Tuple(std::vector<Value> values, const Schema *schema);
+
+  // materialize a view, deep copy
+  explicit Tuple(const TupleRef &other);
+
+  Tuple(const Tuple &other) : Tuple(static_cast<const TupleRef &>(other)) {}
+
+  // move constructor
+  Tuple(Tuple &&other) noexcept;
+
+  ~Tuple() = default;
+
+  // assign operator, deep copy
+  auto operator=(const Tuple &other) -> Tuple &;
+
+  // assign from a view, deep copy
+  auto operator=(const TupleRef &other) -> Tuple &;
+
+  // move assignment
+  auto operator=(Tuple &&other) noexcept -> Tuple &;
+
+  // deserialize tuple data(deep copy)
+  void DeserializeFrom(const char *storage);
+
+ private:
+  // Point the view at the owned bytes after they have been (re)allocated.
+  void Bind() {
+    data_ = buffer_.data();
+    length_ = buffer_.size();
+  }
+
+  std::vector<char> buffer_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,149 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+#include "type/type_id.h"
+
+namespace bustub {
+
+static auto IsIntegral(TypeId type) -> bool {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+
+/** Tighten one end of the range with `value`, the new bound being a lower bound if is_lower. */
+static void TightenBound(std::optional<Value> *bound, bool *inclusive, const Value &value, bool value_inclusive,
+                         bool is_lower) {
+  if (!bound->has_value()) {
+    *bound = value;
+    *inclusive = value_inclusive;
+    return;
+  }
+  auto tighter = is_lower ? value.CompareGreaterThan(**bound) : value.CompareLessThan(**bound);
+  if (tighter == CmpBool::CmpTrue) {
+    *bound = value;
+    *inclusive = value_inclusive;
+  } else if (value.CompareEquals(**bound) == CmpBool::CmpTrue) {
+    *inclusive = *inclusive && value_inclusive;
+  }
+}
+
+/**
+ * Collect the bounds that the conjuncts of `expr` put on column `col_idx`. Only `column <op> constant` comparisons
+ * whose constant keeps its value when cast to the key type are used; anything else is left to the filter.
+ */
+static void ExtractRange(const AbstractExpressionRef &expr, uint32_t col_idx, TypeId key_type, IndexScanRange *range) {
+  if (const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr.get()); logic_expr != nullptr) {
+    if (logic_expr->logic_type_ == LogicType::And) {
+      ExtractRange(logic_expr->GetChildAt(0), col_idx, key_type, range);
+      ExtractRange(logic_expr->GetChildAt(1), col_idx, key_type, range);
+    }
+    return;
+  }
+  const auto *cmp_expr = dynamic_cast<const ComparisonExpression *>(expr.get());
+  if (cmp_expr == nullptr) {
+    return;
+  }
+  auto comp_type = cmp_expr->comp_type_;
+  const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(cmp_expr->GetChildAt(0).get());
+  const auto *constant_expr = dynamic_cast<const ConstantValueExpression *>(cmp_expr->GetChildAt(1).get());
+  if (column_expr == nullptr) {
+    // `constant <op> column`: flip it around.
+    column_expr = dynamic_cast<const ColumnValueExpression *>(cmp_expr->GetChildAt(1).get());
+    constant_expr = dynamic_cast<const ConstantValueExpression *>(cmp_expr->GetChildAt(0).get());
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  if (column_expr == nullptr || constant_expr == nullptr || column_expr->GetTupleIdx() != 0 ||
+      column_expr->GetColIdx() != col_idx) {
+    return;
+  }
+  const auto &constant = constant_expr->val_;
+  auto constant_type = constant.GetTypeId();
+  if (constant.IsNull() ||
+      !(constant_type == key_type || (IsIntegral(constant_type) && IsIntegral(key_type) && constant_type < key_type))) {
+    return;
+  }
+  auto value = constant.CastAs(key_type);
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      TightenBound(&range->lower_, &range->lower_inclusive_, value, true, true);
+      TightenBound(&range->upper_, &range->upper_inclusive_, value, true, false);
+      break;
+    case ComparisonType::GreaterThan:
+    case ComparisonType::GreaterThanOrEqual:
+      TightenBound(&range->lower_, &range->lower_inclusive_, value, comp_type == ComparisonType::GreaterThanOrEqual,
+                   true);
+      break;
+    case ComparisonType::LessThan:
+    case ComparisonType::LessThanOrEqual:
+      TightenBound(&range->upper_, &range->upper_inclusive_, value, comp_type == ComparisonType::LessThanOrEqual,
+                   false);
+      break;
+    default:
+      break;
+  }
+}
+
+auto Optimizer::OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeFilterAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::Filter) {
+    return optimized_plan;
+  }
+  const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+  const auto &child_plan = filter_plan.GetChildPlan();
+  if (child_plan->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
+  if (seq_scan.filter_predicate_ != nullptr) {
+    return optimized_plan;
+  }
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+  for (const auto *index : catalog_.GetTableIndexes(table_info->name_)) {
+    const auto &columns = index->key_schema_.GetColumns();
+    if (columns.size() != 1) {
+      continue;
+    }
+    auto col_idx = table_info->schema_.TryGetColIdx(columns[0].GetName());
+    if (!col_idx.has_value()) {
+      continue;
+    }
+    IndexScanRange range;
+    ExtractRange(filter_plan.GetPredicate(), *col_idx, columns[0].GetType(), &range);
+    if (!range.IsFull()) {
+      auto index_scan = std::make_shared<IndexScanPlanNode>(seq_scan.output_schema_, index->index_oid_, range);
+      return filter_plan.CloneWithChildren({index_scan});
+    }
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
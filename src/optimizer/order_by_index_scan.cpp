@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <memory>
+#include <optional>
 
 #include "binder/bound_order_by.h"
 #include "catalog/catalog.h"
@@ -33,11 +34,14 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &order_bys = sort_plan.GetOrderBy();
 
     std::vector<uint32_t> order_by_column_ids;
+    // All columns ascending scans the index forwards, all descending scans it backwards.
+    std::optional<bool> reverse;
     for (const auto &[order_type, expr] : order_bys) {
-      // Order type is asc or default
-      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+      bool desc = order_type == OrderByType::DESC;
+      if (order_type == OrderByType::INVALID || (reverse.has_value() && *reverse != desc)) {
         return optimized_plan;
       }
+      reverse = desc;
 
       // Order expression is a column value expression
       const auto *column_value_expr = dynamic_cast<ColumnValueExpression *>(expr.get());
@@ -52,28 +56,53 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     BUSTUB_ENSURE(optimized_plan->children_.size() == 1, "Sort with multiple children?? Impossible!");
     const auto &child_plan = optimized_plan->children_[0];
 
-    if (child_plan->GetType() == PlanType::SeqScan) {
-      const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
+    // A filter keeps the order of its input, so the sort can also go if the filter sits on the scan.
+    const auto *filter_plan = dynamic_cast<const FilterPlanNode *>(child_plan.get());
+    const auto &scan_plan = filter_plan != nullptr ? filter_plan->GetChildPlan() : child_plan;
+
+    auto index_matches = [&](const IndexInfo *index, const TableInfo *table_info) {
+      const auto &columns = index->key_schema_.GetColumns();
+      // check index key schema == order by columns
+      if (columns.size() != order_by_column_ids.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].GetName() != table_info->schema_.GetColumn(order_by_column_ids[i]).GetName()) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto with_scan = [&](AbstractPlanNodeRef index_scan) -> AbstractPlanNodeRef {
+      if (filter_plan != nullptr) {
+        return filter_plan->CloneWithChildren({std::move(index_scan)});
+      }
+      return index_scan;
+    };
+
+    if (scan_plan->GetType() == PlanType::SeqScan) {
+      const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*scan_plan);
       const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
 
       for (const auto *index : indices) {
-        const auto &columns = index->key_schema_.GetColumns();
-        // check index key schema == order by columns
-        bool valid = true;
-        if (columns.size() == order_by_column_ids.size()) {
-          for (size_t i = 0; i < columns.size(); i++) {
-            if (columns[i].GetName() != table_info->schema_.GetColumn(order_by_column_ids[i]).GetName()) {
-              valid = false;
-              break;
-            }
-          }
-          if (valid) {
-            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
-          }
+        if (index_matches(index, table_info)) {
+          return with_scan(std::make_shared<IndexScanPlanNode>(seq_scan.output_schema_, index->index_oid_,
+                                                               IndexScanRange{}, reverse.value_or(false)));
         }
       }
     }
+
+    // A range scan produced by OptimizeFilterAsIndexScan() already walks the right index.
+    if (scan_plan->GetType() == PlanType::IndexScan) {
+      const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*scan_plan);
+      const auto *index = catalog_.GetIndex(index_scan.GetIndexOid());
+      const auto *table_info = catalog_.GetTable(index->table_name_);
+      if (!index_scan.IsReverse() && index_matches(index, table_info)) {
+        return with_scan(std::make_shared<IndexScanPlanNode>(index_scan.output_schema_, index->index_oid_,
+                                                             index_scan.GetRange(), reverse.value_or(false)));
+      }
+    }
   }
 
   return optimized_plan;
@@ -0,0 +1,126 @@
+#include <memory>
+#include <utility>
+#include <vector>
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Mark the columns an expression over a single input tuple reads. */
+void CollectColumns(const AbstractExpressionRef &expr, std::vector<bool> *used) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    (*used)[column->GetColIdx()] = true;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, used);
+  }
+}
+
+void CollectColumns(const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys,
+                    std::vector<bool> *used) {
+  for (const auto &[type, expr] : order_bys) {
+    CollectColumns(expr, used);
+  }
+}
+
+}  // namespace
+
+auto Optimizer::OptimizePruneScanColumns(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  return PruneScanColumns(plan, std::vector<bool>(plan->OutputSchema().GetColumnCount(), true));
+}
+
+auto Optimizer::PruneScanColumns(const AbstractPlanNodeRef &plan, std::vector<bool> used) -> AbstractPlanNodeRef {
+  if (plan->GetType() == PlanType::SeqScan) {
+    const auto &seq_scan_plan = dynamic_cast<const SeqScanPlanNode &>(*plan);
+    const auto *table_info = catalog_.GetTable(seq_scan_plan.table_oid_);
+    if (table_info->table_ == nullptr || table_info->table_->GetStorage() != TableStorage::Pax) {
+      return plan;
+    }
+    CollectColumns(seq_scan_plan.filter_predicate_, &used);
+    std::vector<uint32_t> columns;
+    for (uint32_t i = 0; i < used.size(); i++) {
+      if (used[i]) {
+        columns.push_back(i);
+      }
+    }
+    if (columns.size() == used.size()) {
+      return plan;
+    }
+    // A scan that needs no column at all still has to read one, which keeps the columns from meaning "all".
+    if (columns.empty()) {
+      columns.push_back(0);
+    }
+    return std::make_shared<SeqScanPlanNode>(seq_scan_plan.output_schema_, seq_scan_plan.table_oid_,
+                                             seq_scan_plan.table_name_, seq_scan_plan.filter_predicate_,
+                                             std::move(columns));
+  }
+
+  // Work out which columns of its child each node needs. Filters, sorts and limits pass on the tuples of their child,
+  // so they need what their parent does besides their own columns. For other nodes, all columns are kept.
+  std::vector<bool> child_used;
+  switch (plan->GetType()) {
+    case PlanType::Projection: {
+      const auto &projection_plan = dynamic_cast<const ProjectionPlanNode &>(*plan);
+      child_used.resize(projection_plan.GetChildPlan()->OutputSchema().GetColumnCount());
+      for (const auto &expr : projection_plan.GetExpressions()) {
+        CollectColumns(expr, &child_used);
+      }
+      break;
+    }
+    case PlanType::Aggregation: {
+      const auto &aggregation_plan = dynamic_cast<const AggregationPlanNode &>(*plan);
+      child_used.resize(aggregation_plan.GetChildPlan()->OutputSchema().GetColumnCount());
+      for (const auto &expr : aggregation_plan.GetGroupBys()) {
+        CollectColumns(expr, &child_used);
+      }
+      for (const auto &expr : aggregation_plan.GetAggregates()) {
+        CollectColumns(expr, &child_used);
+      }
+      break;
+    }
+    case PlanType::Filter: {
+      child_used = std::move(used);
+      CollectColumns(dynamic_cast<const FilterPlanNode &>(*plan).GetPredicate(), &child_used);
+      break;
+    }
+    case PlanType::Sort: {
+      child_used = std::move(used);
+      CollectColumns(dynamic_cast<const SortPlanNode &>(*plan).GetOrderBy(), &child_used);
+      break;
+    }
+    case PlanType::TopN: {
+      child_used = std::move(used);
+      CollectColumns(dynamic_cast<const TopNPlanNode &>(*plan).GetOrderBy(), &child_used);
+      break;
+    }
+    case PlanType::Limit: {
+      child_used = std::move(used);
+      break;
+    }
+    default:
+      break;
+  }
+
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    auto child_columns = child_used.empty() ? std::vector<bool>(child->OutputSchema().GetColumnCount(), true)
+                                            : child_used;
+    children.emplace_back(PruneScanColumns(child, std::move(child_columns)));
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace bustub
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -31,10 +32,33 @@ static char *buffer_used;
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+  if (!OpenLogFile()) {
+    return;
+  }
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // directory or file does not exist
+  if (!db_io_.is_open()) {
+    db_io_.clear();
+    // create a new file
+    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!db_io_.is_open()) {
+      throw Exception("can't open db file");
+    }
+  }
+  db_file_size_ = std::max<int64_t>(GetFileSize(file_name_), 0);
+  buffer_used = nullptr;
+}
+
+/**
+ * Open/create the log file next to the database file
+ */
+auto DiskManager::OpenLogFile() -> bool {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
-    return;
+    return false;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
@@ -48,19 +72,7 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw Exception("can't open dblog file");
     }
   }
-
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
-  }
-  buffer_used = nullptr;
+  return true;
 }
 
 /**
@@ -79,33 +91,43 @@ void DiskManager::ShutDown() {
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  int64_t offset = PageOffset(page_id);
   // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
+  db_io_.seekp(static_cast<std::streamoff>(offset));
   db_io_.write(page_data, BUSTUB_PAGE_SIZE);
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
+  db_file_size_ = std::max(db_file_size_, offset + BUSTUB_PAGE_SIZE);
   // needs to flush to keep disk file in sync
   db_io_.flush();
 }
 
+/**
+ * Write a batch of pages, one at a time
+ */
+void DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  for (const auto &[page_id, page_data] : pages) {
+    WritePage(page_id, page_data);
+  }
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+  int64_t offset = PageOffset(page_id);
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset >= db_file_size_) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
   } else {
     // set read cursor to offset
-    db_io_.seekp(offset);
+    db_io_.seekp(static_cast<std::streamoff>(offset));
     db_io_.read(page_data, BUSTUB_PAGE_SIZE);
     if (db_io_.bad()) {
       LOG_DEBUG("I/O error while reading");
@@ -161,13 +183,13 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
+  log_io_.seekp(static_cast<std::streamoff>(offset));
   log_io_.read(log_data, size);
 
   if (log_io_.bad()) {
@@ -187,12 +209,12 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
 /**
  * Returns number of flushes made so far
  */
-auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
+auto DiskManager::GetNumFlushes() const -> int64_t { return num_flushes_; }
 
 /**
  * Returns number of Writes made so far
  */
-auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
+auto DiskManager::GetNumWrites() const -> int64_t { return num_writes_; }
 
 /**
  * Returns true if the log is currently being flushed
@@ -202,10 +224,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
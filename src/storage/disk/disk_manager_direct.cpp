@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_direct.cpp
+//
+// Identification: src/storage/disk/disk_manager_direct.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_direct.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+/** O_DIRECT needs buffers, offsets and lengths aligned to the logical block size; a page is always enough. */
+static constexpr size_t DIRECT_IO_ALIGNMENT = BUSTUB_PAGE_SIZE;
+
+using AlignedBuffer = std::unique_ptr<char, decltype(&std::free)>;
+
+static auto AllocateAligned(size_t pages) -> AlignedBuffer {
+  return {static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, pages * BUSTUB_PAGE_SIZE)), &std::free};
+}
+
+static auto IsAligned(const void *ptr) -> bool { return reinterpret_cast<uintptr_t>(ptr) % DIRECT_IO_ALIGNMENT == 0; }
+
+/** One aligned page per thread, used to stage unaligned page buffers. */
+static auto StagingPage() -> char * {
+  thread_local AlignedBuffer buffer = AllocateAligned(1);
+  return buffer.get();
+}
+
+/** pwrite the whole buffer, retrying on short writes. */
+static auto WriteAll(int fd, const char *data, size_t size, off_t offset) -> bool {
+  while (size > 0) {
+    auto written = pwrite(fd, data, size, offset);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+DiskManagerDirect::DiskManagerDirect(const std::string &db_file, bool direct_io) : direct_io_(direct_io) {
+  file_name_ = db_file;
+  OpenLogFile();
+
+  int flags = O_RDWR | O_CREAT;
+  db_fd_ = open(db_file.c_str(), flags | (direct_io_ ? O_DIRECT : 0), 0644);
+  if (db_fd_ < 0 && direct_io_ && errno == EINVAL) {
+    // e.g. tmpfs does not support O_DIRECT
+    LOG_DEBUG("O_DIRECT not supported, falling back to buffered I/O");
+    direct_io_ = false;
+    db_fd_ = open(db_file.c_str(), flags, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+}
+
+DiskManagerDirect::~DiskManagerDirect() { ShutDown(); }
+
+void DiskManagerDirect::ShutDown() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  log_io_.close();
+}
+
+void DiskManagerDirect::WritePage(page_id_t page_id, const char *page_data) {
+  num_writes_ += 1;
+  if (direct_io_ && !IsAligned(page_data)) {
+    auto staging = StagingPage();
+    memcpy(staging, page_data, BUSTUB_PAGE_SIZE);
+    page_data = staging;
+  }
+  if (!WriteAll(db_fd_, page_data, BUSTUB_PAGE_SIZE, PageOffset(page_id))) {
+    LOG_DEBUG("I/O error while writing");
+  }
+}
+
+void DiskManagerDirect::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  auto sorted = pages;
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<const char *> run;
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  for (const auto &[page_id, page_data] : sorted) {
+    if (!run.empty() && page_id != first_page_id + static_cast<page_id_t>(run.size())) {
+      WriteRun(first_page_id, run);
+      run.clear();
+    }
+    if (run.empty()) {
+      first_page_id = page_id;
+    }
+    run.push_back(page_data);
+  }
+  if (!run.empty()) {
+    WriteRun(first_page_id, run);
+  }
+}
+
+void DiskManagerDirect::WriteRun(page_id_t first_page_id, const std::vector<const char *> &run) {
+  num_writes_ += run.size();
+  auto offset = PageOffset(first_page_id);
+
+  if (direct_io_ && !std::all_of(run.begin(), run.end(), IsAligned)) {
+    // Gather the run into one aligned buffer and submit it as a single write.
+    auto buffer = AllocateAligned(run.size());
+    for (size_t i = 0; i < run.size(); i++) {
+      memcpy(buffer.get() + i * BUSTUB_PAGE_SIZE, run[i], BUSTUB_PAGE_SIZE);
+    }
+    if (!WriteAll(db_fd_, buffer.get(), run.size() * BUSTUB_PAGE_SIZE, offset)) {
+      LOG_DEBUG("I/O error while writing");
+    }
+    return;
+  }
+
+  for (size_t begin = 0; begin < run.size(); begin += IOV_MAX) {
+    auto end = std::min(run.size(), begin + IOV_MAX);
+    std::vector<iovec> iov;
+    iov.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+      iov.push_back({const_cast<char *>(run[i]), BUSTUB_PAGE_SIZE});  // NOLINT
+    }
+    auto expected = static_cast<ssize_t>((end - begin) * BUSTUB_PAGE_SIZE);
+    auto written = pwritev(db_fd_, iov.data(), static_cast<int>(iov.size()), offset);
+    if (written != expected) {
+      // Short or failed vectored write: finish page by page.
+      auto done_pages = written > 0 ? written / BUSTUB_PAGE_SIZE : 0;
+      for (auto i = begin + done_pages; i < end; i++) {
+        if (!WriteAll(db_fd_, run[i], BUSTUB_PAGE_SIZE, PageOffset(first_page_id + i))) {
+          LOG_DEBUG("I/O error while writing");
+        }
+      }
+    }
+    offset += expected;
+  }
+}
+
+void DiskManagerDirect::ReadPage(page_id_t page_id, char *page_data) {
+  auto buffer = direct_io_ && !IsAligned(page_data) ? StagingPage() : page_data;
+  size_t read_count = 0;
+  while (read_count < BUSTUB_PAGE_SIZE) {
+    auto bytes = pread(db_fd_, buffer + read_count, BUSTUB_PAGE_SIZE - read_count, PageOffset(page_id) + read_count);
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes < 0) {
+      LOG_DEBUG("I/O error while reading");
+      break;
+    }
+    if (bytes == 0) {
+      // reading past the end of the file
+      break;
+    }
+    read_count += bytes;
+  }
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(buffer + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, BUSTUB_PAGE_SIZE);
+  }
+}
+
+}  // namespace bustub
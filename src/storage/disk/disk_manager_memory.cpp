@@ -33,7 +33,7 @@ DiskManagerMemory::DiskManagerMemory(size_t pages) { memory_ = new char[pages *
  * Write the contents of the specified page into disk file
  */
 void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  int64_t offset = PageOffset(page_id);
   // set write cursor to offset
   num_writes_ += 1;
   memcpy(memory_ + offset, page_data, BUSTUB_PAGE_SIZE);
@@ -43,7 +43,7 @@ void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
  * Read the contents of the specified page into the given memory area
  */
 void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
-  int64_t offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
+  int64_t offset = PageOffset(page_id);
   memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
 }
 
@@ -1,7 +1,10 @@
+#include <algorithm>
+#include <limits>
 #include <sstream>
 #include <string>
 
 #include "common/exception.h"
+#include "fmt/format.h"
 #include "common/logger.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
@@ -17,18 +20,87 @@ Context::~Context() {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
-                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size)
+                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size, bool unique)
     : index_name_(std::move(name)),
       bpm_(buffer_pool_manager),
       comparator_(std::move(comparator)),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size),
-      header_page_id_(header_page_id) {
+      header_page_id_(header_page_id),
+      unique_(unique) {
+  BUSTUB_ENSURE(unique_ || sizeof(KeyType) > sizeof(ValueType), "the keys of a non-unique tree have no room for values");
   WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
   auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
   root_page->root_page_id_ = INVALID_PAGE_ID;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() { StopBackgroundCompactor(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartBackgroundCompactor() {
+  std::scoped_lock<std::mutex> lock(compactor_latch_);
+  if (!compactor_thread_.joinable()) {
+    compactor_stop_ = false;
+    lazy_remove_ = true;
+    compactor_thread_ = std::thread([this]() { CompactorWorker(); });
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StopBackgroundCompactor() {
+  {
+    std::scoped_lock<std::mutex> lock(compactor_latch_);
+    lazy_remove_ = false;
+    compactor_stop_ = true;
+  }
+  compactor_cv_.notify_all();
+  if (compactor_thread_.joinable()) {
+    compactor_thread_.join();
+  }
+  // A remove racing with the stop may have queued its leaf after the worker finished.
+  std::deque<page_id_t> queue;
+  std::unordered_map<page_id_t, KeyType> underfull_pages;
+  {
+    std::scoped_lock<std::mutex> lock(compactor_latch_);
+    queue.swap(compaction_queue_);
+    underfull_pages.swap(underfull_pages_);
+  }
+  for (auto page_id : queue) {
+    CompactLeaf(underfull_pages.at(page_id));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CompactorWorker() {
+  std::unique_lock<std::mutex> lock(compactor_latch_);
+  while (true) {
+    compactor_cv_.wait(lock, [this]() { return compactor_stop_ || !compaction_queue_.empty(); });
+    // Once stopped, removes are eager again, so draining the queue leaves every leaf at its minimum size.
+    if (compaction_queue_.empty()) {
+      return;
+    }
+    auto page_id = compaction_queue_.front();
+    compaction_queue_.pop_front();
+    auto key = underfull_pages_.at(page_id);
+    underfull_pages_.erase(page_id);
+    lock.unlock();
+    CompactLeaf(key);
+    lock.lock();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CompactLeaf(const KeyType &key) {
+  ModificationGuard modification(this);
+  Context ctx;
+  auto leaf_page_id = FindLeafToModify(key, ctx, ModificationType::DELETE);
+  if (leaf_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  RebalanceLeaf(leaf_page_id, key, ctx);
+}
+
 /*
  * Helper function to decide whether current b+tree is empty
  */
@@ -48,9 +120,44 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
-  // Declaration of context instance.
+  if (!unique_) {
+    // The entries of the key are next to each other, ordered by value.
+    KeyRange<KeyType> range;
+    range.lower_ = key;
+    range.upper_ = key;
+    auto num_values = result->size();
+    for (auto iterator = Scan(range); !iterator.IsEnd(); ++iterator) {
+      result->push_back((*iterator).second);
+    }
+    return result->size() > num_values;
+  }
+
+  // Point lookups never latch a page unless writers keep invalidating them.
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+    BasicPageGuard leaf_guard;
+    uint64_t leaf_version;
+    auto page_id = TryFindLeafToRead(key, false, &leaf_guard, &leaf_version);
+    if (!page_id.has_value()) {
+      continue;
+    }
+    if (*page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    auto *leaf_page = leaf_guard.As<LeafPage>();
+    auto [index, equal] = leaf_page->Lookup(key, comparator_);
+    ValueType value{};
+    if (equal) {
+      value = leaf_page->ValueAt(index);
+    }
+    if (leaf_guard.ValidateVersion(leaf_version)) {
+      if (equal) {
+        result->push_back(value);
+      }
+      return equal;
+    }
+  }
+
   Context ctx;
-  (void)ctx;
   auto page_id = FindLeafToRead(key, false, ctx);
   if (page_id == INVALID_PAGE_ID) {
     return false;
@@ -72,15 +179,34 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if user try to insert duplicate keys (or, in a non-unique tree, a
+ * duplicate key & value pair) return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *txn) -> bool {
+  ModificationGuard modification(this);
+  auto tree_key = unique_ ? key : TreeKey(key, value);
+  {
+    // Most inserts fit into the leaf. Only if this one would split it, start over holding write latches from the top.
+    Context ctx;
+    if (FindLeafOptimistic(tree_key, ctx) != INVALID_PAGE_ID) {
+      auto &leaf_page_guard = ctx.write_set_.back();
+      auto *leaf_page = leaf_page_guard.As<LeafPage>();
+      auto [index, equal] = leaf_page->Lookup(tree_key, comparator_);
+      if (equal) {
+        return false;
+      }
+      if (leaf_page->GetSize() + 1 < leaf_page->GetMaxSize()) {
+        leaf_page_guard.AsMut<LeafPage>()->Insert(tree_key, value, comparator_);
+        return true;
+      }
+    }
+  }
+
   // Declaration of context instance.
   Context ctx;
   (void)ctx;
-  auto leaf_page_id = FindLeafToModify(key, ctx, ModificationType::INSERT);
+  auto leaf_page_id = FindLeafToModify(tree_key, ctx, ModificationType::INSERT);
   if (leaf_page_id == INVALID_PAGE_ID) {
     return false;
   }
@@ -88,12 +214,12 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   auto leaf_page_guard = std::move(ctx.write_set_.back());
   ctx.write_set_.pop_back();
   auto *leaf_page = leaf_page_guard.AsMut<LeafPage>();
-  auto [index, equal] = leaf_page->Lookup(key, comparator_);
+  auto [index, equal] = leaf_page->Lookup(tree_key, comparator_);
   if (equal) {
     return false;
   }
 
-  leaf_page->Insert(key, value, comparator_);
+  leaf_page->Insert(tree_key, value, comparator_);
   if (leaf_page->GetSize() < leaf_page->GetMaxSize()) {
     return true;
   }
@@ -112,6 +238,108 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   return true;
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Split num_entries entries into nodes of per_node entries. If the last node ends up below min_size, it is merged
+ * into the node before it, and the two are split evenly again if they do not fit into one node.
+ */
+static auto BulkLoadNodeSizes(size_t num_entries, int per_node, int min_size, int max_size) -> std::vector<int> {
+  std::vector<int> sizes(num_entries / per_node, per_node);
+  if (num_entries % per_node != 0) {
+    sizes.push_back(static_cast<int>(num_entries % per_node));
+  }
+  if (sizes.size() > 1 && sizes.back() < min_size) {
+    int combined = sizes.back() + sizes[sizes.size() - 2];
+    sizes.pop_back();
+    if (combined <= max_size) {
+      sizes.back() = combined;
+    } else {
+      sizes.back() = combined / 2;
+      sizes.push_back(combined - combined / 2);
+    }
+  }
+  return sizes;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(BulkLoadIterator begin, BulkLoadIterator end, double fill_factor) -> bool {
+  BUSTUB_ENSURE(fill_factor > 0 && fill_factor <= 1, "fill factor must be in (0, 1]");
+  ModificationGuard modification(this);
+  auto tree_key = [this](BulkLoadIterator it) { return unique_ ? it->first : TreeKey(it->first, it->second); };
+  size_t num_keys = begin == end ? 0 : 1;
+  for (auto it = begin; it != end && std::next(it) != end; ++it) {
+    auto cmp = comparator_(tree_key(it), tree_key(std::next(it)));
+    if (cmp > 0) {
+      throw Exception(ExceptionType::INVALID, "bulk load input is not sorted");
+    }
+    num_keys += cmp < 0 ? 1 : 0;
+  }
+
+  Context ctx;
+  ctx.header_page_ = bpm_->FetchPageWrite(header_page_id_);
+  if (ctx.header_page_->As<BPlusTreeHeaderPage>()->root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  if (num_keys == 0) {
+    return true;
+  }
+
+  // A leaf splits as soon as it reaches its max size, an internal page only once it would exceed it. The minimum
+  // sizes are those of BPlusTreePage::GetMinSize().
+  int leaf_capacity = leaf_max_size_ - 1;
+  int leaf_min_size = std::max(leaf_max_size_ / 2, 1);
+  int per_leaf = std::clamp(static_cast<int>(fill_factor * leaf_capacity), leaf_min_size, leaf_capacity);
+  int internal_min_size = std::max((internal_max_size_ + 1) / 2, 2);
+  int per_internal = std::clamp(static_cast<int>(fill_factor * internal_max_size_), internal_min_size,
+                                std::max(internal_max_size_, 2));
+
+  // First key and page id of every node on the level built last.
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  auto it = begin;
+  std::optional<WritePageGuard> prev_leaf_guard;
+  for (int size : BulkLoadNodeSizes(num_keys, per_leaf, leaf_min_size, leaf_capacity)) {
+    page_id_t page_id;
+    bpm_->NewPageGuarded(&page_id);
+    auto leaf_guard = bpm_->FetchPageWrite(page_id);
+    auto *leaf_page = leaf_guard.AsMut<LeafPage>();
+    leaf_page->Init(leaf_max_size_);
+    while (leaf_page->GetSize() < size) {
+      if (it == begin || comparator_(tree_key(std::prev(it)), tree_key(it)) != 0) {
+        leaf_page->Insert(tree_key(it), it->second, comparator_);
+      }
+      ++it;
+    }
+    if (prev_leaf_guard.has_value()) {
+      prev_leaf_guard->AsMut<LeafPage>()->SetNextPageId(page_id);
+    }
+    level.emplace_back(leaf_page->KeyAt(0), page_id);
+    prev_leaf_guard = std::move(leaf_guard);
+  }
+  prev_leaf_guard.reset();
+
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parent_level;
+    size_t child = 0;
+    for (int size : BulkLoadNodeSizes(level.size(), per_internal, internal_min_size, internal_max_size_)) {
+      page_id_t page_id;
+      bpm_->NewPageGuarded(&page_id);
+      auto internal_guard = bpm_->FetchPageWrite(page_id);
+      auto *internal_page = internal_guard.AsMut<InternalPage>();
+      internal_page->Init(internal_max_size_);
+      parent_level.emplace_back(level[child].first, page_id);
+      internal_page->InsertFirstValue(level[child++].second);
+      for (int i = 1; i < size; i++, child++) {
+        internal_page->InsertAt(i, level[child].first, level[child].second);
+      }
+    }
+    level = std::move(parent_level);
+  }
+  SetRootPage(level[0].second, ctx);
+  return true;
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -124,14 +352,61 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
+  BUSTUB_ENSURE(unique_, "a non-unique tree needs the value to remove");
+  Remove(key, ValueType{}, txn);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *txn) {
+  ModificationGuard modification(this);
+  auto tree_key = unique_ ? key : TreeKey(key, value);
+  {
+    // Likewise, only a remove that would leave the leaf underfull needs the pessimistic path.
+    Context ctx;
+    auto leaf_page_id = FindLeafOptimistic(tree_key, ctx);
+    if (leaf_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    auto &leaf_page_guard = ctx.write_set_.back();
+    auto *leaf_page = leaf_page_guard.As<LeafPage>();
+    auto [index, equal] = leaf_page->Lookup(tree_key, comparator_);
+    if (!equal) {
+      return;
+    }
+    // An emptied root leaf is deleted, any other leaf must keep its minimum size.
+    int min_size = ctx.IsRootPage(leaf_page_id) ? 1 : leaf_page->GetMinSize();
+    if (leaf_page->GetSize() > min_size) {
+      leaf_page_guard.AsMut<LeafPage>()->Remove(tree_key, comparator_);
+      return;
+    }
+    // A lazy remove leaves the merge to the compactor, unless too many leaves are waiting for it already.
+    if (lazy_remove_ && !ctx.IsRootPage(leaf_page_id)) {
+      std::unique_lock<std::mutex> lock(compactor_latch_);
+      bool is_queued = underfull_pages_.count(leaf_page_id) > 0;
+      if (is_queued || compaction_queue_.size() < MAX_QUEUED_LEAVES) {
+        underfull_pages_.insert_or_assign(leaf_page_id, tree_key);
+        if (!is_queued) {
+          compaction_queue_.push_back(leaf_page_id);
+        }
+        lock.unlock();
+        leaf_page_guard.AsMut<LeafPage>()->Remove(tree_key, comparator_);
+        leaf_page_guard.Drop();
+        if (!is_queued) {
+          compactor_cv_.notify_one();
+        }
+        return;
+      }
+    }
+  }
+
   // Declaration of context instance.
   Context ctx;
   (void)ctx;
-  auto leaf_page_id = FindLeafToModify(key, ctx, ModificationType::DELETE);
+  auto leaf_page_id = FindLeafToModify(tree_key, ctx, ModificationType::DELETE);
   if (leaf_page_id == INVALID_PAGE_ID) {
     return;
   }
-  RemoveLeaf(leaf_page_id, key, ctx);
+  RemoveLeaf(leaf_page_id, tree_key, ctx);
 }
 
 /*****************************************************************************
@@ -143,18 +418,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  // Declaration of context instance.
-  Context ctx;
-  (void)ctx;
-  auto page_id = FindLeafToRead(KeyType{}, false, ctx);
-  if (page_id == INVALID_PAGE_ID) {
-    return INDEXITERATOR_TYPE();
-  }
-  auto leaf_page_guard = std::move(ctx.read_set_.back());
-  ctx.read_set_.pop_back();
-  return INDEXITERATOR_TYPE(page_id, 0, std::move(leaf_page_guard), bpm_);
-}
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return Scan({}); }
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -163,17 +427,49 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  KeyRange<KeyType> range;
+  range.lower_ = key;
+  return Scan(range);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Scan(const KeyRange<KeyType> &user_range, bool reverse) -> INDEXITERATOR_TYPE {
+  auto range = user_range;
+  if (!unique_) {
+    // Widen each bound to take in, or to leave out, every value stored under its key.
+    const ValueType min_value(std::numeric_limits<page_id_t>::min(), 0);
+    const ValueType max_value(std::numeric_limits<page_id_t>::max(), std::numeric_limits<uint32_t>::max());
+    if (range.lower_.has_value()) {
+      range.lower_ = TreeKey(*range.lower_, range.lower_inclusive_ ? min_value : max_value);
+    }
+    if (range.upper_.has_value()) {
+      range.upper_ = TreeKey(*range.upper_, range.upper_inclusive_ ? max_value : min_value);
+    }
+  }
   Context ctx;
-  (void)ctx;
-  auto page_id = FindLeafToRead(KeyType{}, false, ctx);
+  if (reverse) {
+    auto index = FindLastBefore(range.upper_, range.upper_inclusive_, ctx);
+    if (index < 0) {
+      return INDEXITERATOR_TYPE();
+    }
+    auto leaf_page_guard = std::move(ctx.read_set_.back());
+    ctx.read_set_.pop_back();
+    auto page_id = leaf_page_guard.PageId();
+    return INDEXITERATOR_TYPE(this, page_id, index, std::move(leaf_page_guard), bpm_, range, true);
+  }
+  const auto &lower = range.lower_;
+  auto page_id = FindLeafToRead(lower.value_or(KeyType{}), !lower.has_value(), ctx);
   if (page_id == INVALID_PAGE_ID) {
     return INDEXITERATOR_TYPE();
   }
   auto leaf_page_guard = std::move(ctx.read_set_.back());
   ctx.read_set_.pop_back();
-  auto *leaf_page = leaf_page_guard.As<LeafPage>();
-  auto [index, equal] = leaf_page->Lookup(key, comparator_);
-  return INDEXITERATOR_TYPE(page_id, index, std::move(leaf_page_guard), bpm_);
+  // The iterator moves on to the next leaf by itself if every key of this one is below the lower bound.
+  int index = 0;
+  if (lower.has_value()) {
+    index = leaf_page_guard.As<LeafPage>()->KeyIndex(*lower, comparator_, !range.lower_inclusive_);
+  }
+  return INDEXITERATOR_TYPE(this, page_id, index, std::move(leaf_page_guard), bpm_, range, false);
 }
 
 /*
@@ -231,6 +527,217 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name, Transaction *t
   }
 }
 
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+/** Analyze() cuts the tree into this many subtrees per thread, so that threads finishing early can pick up more. */
+static constexpr size_t SUBTREES_PER_THREAD = 4;
+
+/** At most this many integrity violations are described, the others are only counted. */
+static constexpr size_t MAX_REPORTED_ERRORS = 16;
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SubtreeStats::Report(std::string error) {
+  num_errors_++;
+  if (errors_.size() < MAX_REPORTED_ERRORS) {
+    errors_.push_back(std::move(error));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Analyze(int num_threads, int histogram_buckets) -> BPlusTreeStats<KeyType> {
+  BPlusTreeStats<KeyType> result;
+  // The walk saw a quiescent tree if no modification was running when it began, and none started until it ended.
+  // Modifications count themselves as running before they count as started, so the count has to be read first: a
+  // modification that starts in between is then either seen running or seen to have started.
+  size_t num_modifications = num_modifications_;
+  bool was_active = active_modifications_ > 0;
+  auto root_page_id = GetRootPageId();
+  if (root_page_id == INVALID_PAGE_ID) {
+    return result;
+  }
+
+  // The leftmost path tells the level that every leaf should be on.
+  SubtreeStats top;
+  for (auto page_id = root_page_id;; top.leaf_level_++) {
+    auto guard = bpm_->FetchPageRead(page_id);
+    auto *page = guard.template As<BPlusTreePage>();
+    if (page->IsLeafPage() || page->GetSize() == 0) {
+      break;
+    }
+    page_id = guard.template As<InternalPage>()->ValueAt(0);
+  }
+
+  // Check the top levels one at a time until they hand out enough subtrees to keep every thread busy.
+  std::vector<SubtreeRoot> frontier{{root_page_id, std::nullopt, std::nullopt}};
+  int level = 0;
+  auto num_subtrees = static_cast<size_t>(std::max(num_threads, 1)) * SUBTREES_PER_THREAD;
+  while (level < top.leaf_level_ && frontier.size() < num_subtrees) {
+    std::vector<SubtreeRoot> next_frontier;
+    for (const auto &subtree : frontier) {
+      AnalyzeSubtree(subtree, level, &top, &next_frontier);
+    }
+    frontier = std::move(next_frontier);
+    level++;
+  }
+
+  std::vector<SubtreeStats> parts(frontier.size());
+  std::atomic<size_t> next_subtree{0};
+  auto worker = [&]() {
+    for (auto i = next_subtree++; i < frontier.size(); i = next_subtree++) {
+      parts[i].leaf_level_ = top.leaf_level_;
+      AnalyzeSubtree(frontier[i], level, &parts[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads && static_cast<size_t>(i) < frontier.size(); i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Merge the subtrees in key order.
+  std::vector<SubtreeStats *> in_order{&top};
+  for (auto &part : parts) {
+    in_order.push_back(&part);
+  }
+  std::vector<std::tuple<page_id_t, page_id_t, int, KeyType>> leaves;
+  for (auto *part : in_order) {
+    auto num_levels = std::max(result.pages_.size(), part->pages_.size());
+    result.pages_.resize(num_levels);
+    result.entries_.resize(num_levels);
+    result.capacity_.resize(num_levels);
+    for (size_t i = 0; i < part->pages_.size(); i++) {
+      result.pages_[i] += part->pages_[i];
+      result.entries_[i] += part->entries_[i];
+      result.capacity_[i] += part->capacity_[i];
+    }
+    result.underfull_pages_ += part->underfull_pages_;
+    result.num_errors_ += part->num_errors_;
+    for (auto &error : part->errors_) {
+      if (result.errors_.size() < MAX_REPORTED_ERRORS) {
+        result.errors_.push_back(std::move(error));
+      }
+    }
+    leaves.insert(leaves.end(), part->leaves_.begin(), part->leaves_.end());
+  }
+  result.height_ = result.pages_.size();
+
+  SubtreeStats chain;
+  size_t num_keys = 0;
+  for (const auto &leaf : leaves) {
+    num_keys += std::get<2>(leaf);
+  }
+  size_t keys_so_far = 0;
+  for (size_t i = 0; i < leaves.size(); i++) {
+    auto [page_id, next_page_id, size, first_key] = leaves[i];
+    auto expected_next_page_id = i + 1 < leaves.size() ? std::get<0>(leaves[i + 1]) : INVALID_PAGE_ID;
+    if (next_page_id != expected_next_page_id) {
+      chain.Report(fmt::format("leaf page {} links to page {} instead of page {}", page_id, next_page_id,
+                               expected_next_page_id));
+    }
+    if (next_page_id != INVALID_PAGE_ID && next_page_id != page_id + 1) {
+      result.leaf_chain_breaks_++;
+    }
+    // Buckets start at leaf boundaries, at the first leaf past each equal share of the keys.
+    if (size > 0 && (result.histogram_.empty() ||
+                     keys_so_far * histogram_buckets >= result.histogram_.size() * num_keys)) {
+      result.histogram_.emplace_back(first_key, 0);
+    }
+    if (!result.histogram_.empty()) {
+      result.histogram_.back().second += size;
+    }
+    keys_so_far += size;
+  }
+  result.num_errors_ += chain.num_errors_;
+  for (auto &error : chain.errors_) {
+    if (result.errors_.size() < MAX_REPORTED_ERRORS) {
+      result.errors_.push_back(std::move(error));
+    }
+  }
+  result.is_quiescent_ = !was_active && active_modifications_ == 0 && num_modifications_ == num_modifications;
+  if (!result.is_quiescent_) {
+    result.num_errors_ = 0;
+    result.errors_.clear();
+  }
+  return result;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AnalyzeSubtree(const SubtreeRoot &subtree, int level, SubtreeStats *stats,
+                                    std::vector<SubtreeRoot> *frontier) {
+  const auto &[page_id, lower, upper] = subtree;
+  auto guard = bpm_->FetchPageRead(page_id);
+  auto *page = guard.template As<BPlusTreePage>();
+  int size = page->GetSize();
+  if (stats->pages_.size() <= static_cast<size_t>(level)) {
+    stats->pages_.resize(level + 1);
+    stats->entries_.resize(level + 1);
+    stats->capacity_.resize(level + 1);
+  }
+  stats->pages_[level]++;
+  stats->entries_[level] += size;
+  stats->capacity_[level] += page->GetMaxSize();
+  if (level > 0 && size < page->GetMinSize()) {
+    stats->underfull_pages_++;
+  }
+  if (size < 0 || size > page->GetMaxSize()) {
+    stats->Report(fmt::format("page {} holds {} entries, more than its max size {}", page_id, size,
+                              page->GetMaxSize()));
+    return;
+  }
+
+  // Internal pages hold no key at index 0.
+  int first_index = page->IsLeafPage() ? 0 : 1;
+  auto key_at = [&](int index) {
+    return page->IsLeafPage() ? guard.template As<LeafPage>()->KeyAt(index)
+                              : guard.template As<InternalPage>()->KeyAt(index);
+  };
+  for (int i = first_index; i < size; i++) {
+    auto key = key_at(i);
+    if ((lower.has_value() && comparator_(key, *lower) < 0) || (upper.has_value() && comparator_(key, *upper) >= 0)) {
+      stats->Report(fmt::format("key {} of page {} is out of the range of its parent", i, page_id));
+    }
+    if (i > first_index && comparator_(key_at(i - 1), key) >= 0) {
+      stats->Report(fmt::format("keys {} and {} of page {} are out of order", i - 1, i, page_id));
+    }
+  }
+
+  if (page->IsLeafPage()) {
+    if (level != stats->leaf_level_) {
+      stats->Report(fmt::format("leaf page {} is on level {} instead of {}", page_id, level, stats->leaf_level_));
+    }
+    auto *leaf = guard.template As<LeafPage>();
+    stats->leaves_.emplace_back(page_id, leaf->GetNextPageId(), size, size > 0 ? key_at(0) : KeyType{});
+    return;
+  }
+  if (level >= stats->leaf_level_) {
+    stats->Report(fmt::format("internal page {} is on level {}, the level of the leaves", page_id, level));
+    return;
+  }
+  if (size < 2) {
+    stats->Report(fmt::format("internal page {} has {} children", page_id, size));
+  }
+  // Only one page is latched at a time: the children are collected first and walked after the latch is released.
+  auto *internal = guard.template As<InternalPage>();
+  std::vector<SubtreeRoot> children;
+  children.reserve(size);
+  for (int i = 0; i < size; i++) {
+    children.emplace_back(internal->ValueAt(i), i == 0 ? lower : std::optional<KeyType>(key_at(i)),
+                          i + 1 == size ? upper : std::optional<KeyType>(key_at(i + 1)));
+  }
+  guard.Drop();
+  if (frontier != nullptr) {
+    frontier->insert(frontier->end(), children.begin(), children.end());
+    return;
+  }
+  for (const auto &child : children) {
+    AnalyzeSubtree(child, level + 1, stats);
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Print(BufferPoolManager *bpm) {
   auto root_page_id = GetRootPageId();
@@ -456,6 +963,29 @@ auto BPLUSTREE_TYPE::FindLeafToModify(const KeyType &key, Context &ctx, Modifica
   return cur_page_id;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, Context &ctx) -> page_id_t {
+  auto parent_guard = bpm_->FetchPageRead(header_page_id_);
+  ctx.root_page_id_ = parent_guard.template As<BPlusTreeHeaderPage>()->root_page_id_;
+  auto cur_page_id = ctx.root_page_id_;
+  if (cur_page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  while (true) {
+    auto cur_page_guard = bpm_->FetchPageRead(cur_page_id);
+    auto *cur_page = cur_page_guard.template As<InternalPage>();
+    if (cur_page->IsLeafPage()) {
+      // Splits and merges of the leaf need a write latch on its parent (or on the header for the root), which we still
+      // hold in read mode, so the page stays the leaf for key while its latch is swapped for a write latch.
+      cur_page_guard.Drop();
+      ctx.write_set_.push_back(bpm_->FetchPageWrite(cur_page_id));
+      return cur_page_id;
+    }
+    cur_page_id = cur_page->ValueAt(cur_page->Lookup(key, comparator_));
+    parent_guard = std::move(cur_page_guard);
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertToParent(page_id_t left_page_id, page_id_t right_page_id, const KeyType &key, Context &ctx) {
   if (ctx.IsRootPage(left_page_id)) {
@@ -482,7 +1012,7 @@ void BPLUSTREE_TYPE::InsertToParent(page_id_t left_page_id, page_id_t right_page
   int insert_pos = parent_page->Lookup(key, comparator_) + 1;
   int size = parent_page->GetSize();
   int mid_pos = size / 2;
-  assert(insert_pos == size || insert_pos < size && comparator_(parent_page->KeyAt(insert_pos), key) != 0);
+  assert(insert_pos == size || (insert_pos < size && comparator_(parent_page->KeyAt(insert_pos), key) != 0));
 
   page_id_t new_parent_page_id;
   bpm_->NewPageGuarded(&new_parent_page_id);
@@ -539,11 +1069,16 @@ void BPLUSTREE_TYPE::DeleteRootPage(page_id_t page_id, Context &ctx) {
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::RemoveLeaf(page_id_t page_id, const KeyType &key, Context &ctx) {
+  ctx.write_set_.back().template AsMut<LeafPage>()->Remove(key, comparator_);
+  RebalanceLeaf(page_id, key, ctx);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RebalanceLeaf(page_id_t page_id, const KeyType &key, Context &ctx) {
   auto page_guard = std::move(ctx.write_set_.back());
   assert(page_guard.PageId() == page_id);
   ctx.write_set_.pop_back();
   auto *page = page_guard.template AsMut<LeafPage>();
-  page->Remove(key, comparator_);
   if (ctx.IsRootPage(page_id)) {
     if (page->GetSize() == 0) {
       DeleteRootPage(page_id, ctx);
@@ -565,12 +1100,16 @@ void BPLUSTREE_TYPE::RemoveLeaf(page_id_t page_id, const KeyType &key, Context &
   auto *sibling_page = sibling_page_guard.template AsMut<LeafPage>();
 
   if (sibling_page->GetSize() + page->GetSize() >= page->GetMaxSize()) {
-    // rotation
+    // rotation; a leaf emptied by lazy removes may need more than one entry
     if (isLeftSibling) {
-      sibling_page->MoveLastToFirstOf(page);
+      while (page->GetSize() < page->GetMinSize()) {
+        sibling_page->MoveLastToFirstOf(page);
+      }
       parent_page->SetKeyAt(child_index, page->KeyAt(0));
     } else {
-      sibling_page->MoveFirstToLastOf(page);
+      while (page->GetSize() < page->GetMinSize()) {
+        sibling_page->MoveFirstToLastOf(page);
+      }
       parent_page->SetKeyAt(child_index + 1, sibling_page->KeyAt(0));
     }
   } else {
@@ -675,8 +1214,68 @@ auto BPLUSTREE_TYPE::GetSiblingPage(InternalPage *parent_page, const KeyType &ke
   return std::make_tuple(parent_page->ValueAt(index + 1), false, index);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TreeKey(const KeyType &key, const ValueType &value) const -> KeyType {
+  auto tree_key = key;
+  tree_key.SetRid(value);
+  return tree_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryFindLeafToRead(const KeyType &key, bool left_most, BasicPageGuard *leaf_guard,
+                                       uint64_t *leaf_version) -> std::optional<page_id_t> {
+  auto parent_guard = bpm_->FetchPageBasic(header_page_id_);
+  auto parent_version = parent_guard.GetVersion();
+  auto cur_page_id = parent_guard.template As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (!parent_guard.ValidateVersion(parent_version)) {
+    return std::nullopt;
+  }
+  if (cur_page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  while (true) {
+    auto cur_guard = bpm_->FetchPageBasic(cur_page_id);
+    auto cur_version = cur_guard.GetVersion();
+    // The parent still pointing here proves that the page was not merged away or freed before we pinned it.
+    if (!parent_guard.ValidateVersion(parent_version)) {
+      return std::nullopt;
+    }
+    auto *cur_page = cur_guard.template As<InternalPage>();
+    if (cur_page->IsLeafPage()) {
+      *leaf_guard = std::move(cur_guard);
+      *leaf_version = cur_version;
+      return cur_page_id;
+    }
+    auto next_page_id = cur_page->ValueAt(left_most ? 0 : cur_page->Lookup(key, comparator_));
+    if (!cur_guard.ValidateVersion(cur_version)) {
+      return std::nullopt;
+    }
+    parent_guard = std::move(cur_guard);
+    parent_version = cur_version;
+    cur_page_id = next_page_id;
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeafToRead(const KeyType &key, bool left_most, Context &ctx) -> page_id_t {
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+    BasicPageGuard leaf_guard;
+    uint64_t leaf_version;
+    auto page_id = TryFindLeafToRead(key, left_most, &leaf_guard, &leaf_version);
+    if (!page_id.has_value()) {
+      continue;
+    }
+    if (*page_id == INVALID_PAGE_ID) {
+      return INVALID_PAGE_ID;
+    }
+    // The leaf is still the right one if nobody wrote to it between the descent and the read latch.
+    auto leaf_read_guard = bpm_->FetchPageRead(*page_id);
+    if (leaf_guard.ValidateVersion(leaf_version)) {
+      ctx.read_set_.push_back(std::move(leaf_read_guard));
+      return *page_id;
+    }
+  }
+
   auto head_page_guard = bpm_->FetchPageRead(header_page_id_);
   auto *head_page = head_page_guard.template As<BPlusTreeHeaderPage>();
   if (head_page->root_page_id_ == INVALID_PAGE_ID) {
@@ -700,6 +1299,41 @@ auto BPLUSTREE_TYPE::FindLeafToRead(const KeyType &key, bool left_most, Context
   return cur_page_id;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLastBefore(const std::optional<KeyType> &key, bool or_equal, Context &ctx) const -> int {
+  auto target = key;
+  while (true) {
+    auto head_page_guard = bpm_->FetchPageRead(header_page_id_);
+    auto root_page_id = head_page_guard.template As<BPlusTreeHeaderPage>()->root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return -1;
+    }
+    auto cur_page_guard = bpm_->FetchPageRead(root_page_id);
+    head_page_guard.Drop();
+    // Every key in the subtree we descend into is >= this separator.
+    std::optional<KeyType> low_key;
+    while (!cur_page_guard.template As<BPlusTreePage>()->IsLeafPage()) {
+      auto *cur_page = cur_page_guard.template As<InternalPage>();
+      int index = target.has_value() ? cur_page->Lookup(*target, comparator_, or_equal) : cur_page->GetSize() - 1;
+      if (index > 0) {
+        low_key = cur_page->KeyAt(index);
+      }
+      cur_page_guard = bpm_->FetchPageRead(cur_page->ValueAt(index));
+    }
+    auto *leaf_page = cur_page_guard.template As<LeafPage>();
+    int index = (target.has_value() ? leaf_page->KeyIndex(*target, comparator_, or_equal) : leaf_page->GetSize()) - 1;
+    if (index >= 0) {
+      ctx.read_set_.push_back(std::move(cur_page_guard));
+      return index;
+    }
+    if (!low_key.has_value()) {
+      return -1;
+    }
+    target = low_key;
+    or_equal = false;
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::ReleaseAncestors(Context &ctx) {
   if (ctx.header_page_.has_value()) {
@@ -3,6 +3,7 @@
  */
 #include <cassert>
 
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
@@ -15,22 +16,34 @@ INDEXITERATOR_TYPE::IndexIterator() = default;
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, int index, std::optional<ReadPageGuard> read_page_guard,
-                                  BufferPoolManager *buffer_pool_manager)
-    : page_id_(page_id), index_(index), page_guard_(std::move(read_page_guard)), bpm_(buffer_pool_manager) {
+INDEXITERATOR_TYPE::IndexIterator(const BPlusTree<KeyType, ValueType, KeyComparator> *tree, page_id_t page_id,
+                                  int index, std::optional<ReadPageGuard> read_page_guard,
+                                  BufferPoolManager *buffer_pool_manager, KeyRange<KeyType> range, bool reverse)
+    : tree_(tree),
+      range_(std::move(range)),
+      reverse_(reverse),
+      page_id_(page_id),
+      index_(index),
+      page_guard_(std::move(read_page_guard)),
+      bpm_(buffer_pool_manager) {
   if (page_id != INVALID_PAGE_ID) {
     assert(page_guard_.has_value());
     page_ = page_guard_.value().template As<LeafPage>();
+    Settle();
   }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&that) noexcept
-    : page_id_(that.page_id_),
+    : tree_(that.tree_),
+      range_(std::move(that.range_)),
+      reverse_(that.reverse_),
+      page_id_(that.page_id_),
       index_(that.index_),
       page_guard_(std::move(that.page_guard_)),
       bpm_(that.bpm_),
-      page_(that.page_) {}
+      page_(that.page_),
+      pages_until_read_ahead_(that.pages_until_read_ahead_) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator=(IndexIterator &&that) noexcept -> IndexIterator & {
@@ -38,11 +51,15 @@ auto INDEXITERATOR_TYPE::operator=(IndexIterator &&that) noexcept -> IndexIterat
     if (page_guard_.has_value()) {
       page_guard_.reset();
     }
+    tree_ = that.tree_;
+    range_ = std::move(that.range_);
+    reverse_ = that.reverse_;
     page_id_ = that.page_id_;
     index_ = that.index_;
     page_guard_ = std::move(that.page_guard_);
     bpm_ = that.bpm_;
     page_ = that.page_;
+    pages_until_read_ahead_ = that.pages_until_read_ahead_;
     that.page_id_ = INVALID_PAGE_ID;
     that.index_ = -1;
     that.page_guard_ = std::nullopt;
@@ -58,11 +75,18 @@ INDEXITERATOR_TYPE::~IndexIterator() { page_guard_.reset(); };  // NOLINT
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_id_ == INVALID_PAGE_ID; }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::IsLastInLeaf() const -> bool {
+  assert(page_ != nullptr);
+  return reverse_ ? index_ == 0 : index_ == page_->GetSize() - 1;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
   assert(!IsEnd());
   assert(page_ != nullptr);
-  return page_->ItemAt(index_);
+  item_ = page_->ItemAt(index_);
+  return item_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -70,27 +94,79 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   if (IsEnd()) {
     return *this;
   }
-  if (index_ < page_->GetSize() - 1) {
+  if (!reverse_) {
     index_++;
+    Settle();
+    return *this;
+  }
+  if (index_ > 0) {
+    index_--;
+    Settle();
     return *this;
   }
-  auto next_page_id = page_->GetNextPageId();
-  if (next_page_id == INVALID_PAGE_ID) {
-    page_guard_.reset();
-    page_id_ = INVALID_PAGE_ID;
-    page_ = nullptr;
-    index_ = -1;
+  // Release the leaf before descending again: latches are only ever taken top-down and left to right.
+  auto first_key = page_->KeyAt(0);
+  page_guard_.reset();
+  Context ctx;
+  auto index = tree_->FindLastBefore(first_key, false, ctx);
+  if (index < 0) {
+    SetEnd();
     return *this;
   }
-  //  auto next_page_guard = bpm_->FetchPageScan(next_page_id);
-  auto next_page_guard = bpm_->FetchPageRead(next_page_id);
-  page_guard_ = std::move(next_page_guard);
-  page_id_ = next_page_id;
+  page_guard_ = std::move(ctx.read_set_.back());
+  ctx.read_set_.pop_back();
+  page_id_ = page_guard_->PageId();
   page_ = page_guard_.value().template As<LeafPage>();
-  index_ = 0;
+  index_ = index;
+  Settle();
   return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Settle() {
+  while (index_ >= page_->GetSize()) {
+    auto next_page_id = page_->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      SetEnd();
+      return;
+    }
+    if (pages_until_read_ahead_ > 0) {
+      pages_until_read_ahead_--;
+    } else {
+      // Keep the next READ_AHEAD_PAGES leaves in flight, topping the window up every half window.
+      bpm_->PrefetchChain(next_page_id, READ_AHEAD_PAGES,
+                          [](const char *data) { return reinterpret_cast<const LeafPage *>(data)->GetNextPageId(); });
+      pages_until_read_ahead_ = READ_AHEAD_PAGES / 2;
+    }
+    auto next_page_guard = bpm_->FetchPageRead(next_page_id, AccessType::Scan);
+    page_guard_ = std::move(next_page_guard);
+    page_id_ = next_page_id;
+    page_ = page_guard_.value().template As<LeafPage>();
+    index_ = 0;
+  }
+  // Only the bound in the direction of the scan can be crossed; the other one was applied when the scan started.
+  const auto &bound = reverse_ ? range_.lower_ : range_.upper_;
+  if (!bound.has_value()) {
+    return;
+  }
+  auto cmp = tree_->comparator_(page_->KeyAt(index_), *bound);
+  if (reverse_) {
+    cmp = -cmp;
+  }
+  bool inclusive = reverse_ ? range_.lower_inclusive_ : range_.upper_inclusive_;
+  if (cmp > 0 || (cmp == 0 && !inclusive)) {
+    SetEnd();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SetEnd() {
+  page_guard_.reset();
+  page_id_ = INVALID_PAGE_ID;
+  page_ = nullptr;
+  index_ = -1;
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
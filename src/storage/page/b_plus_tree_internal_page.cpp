@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -35,11 +36,10 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
   if (index < 0 || index >= GetSize()) {
     return KeyType{};
   }
-  return array_[index].first;
+  return key_array_[index];
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -47,7 +47,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
   if (index < 0 || index >= GetSize()) {
     return;
   }
-  array_[index].first = key;
+  key_array_[index] = key;
 }
 
 /*
@@ -59,7 +59,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
   if (index < 0 || index >= GetSize()) {
     return ValueType{};
   }
-  return array_[index].second;
+  return ValueArray()[index];
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -74,17 +74,18 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &key, const ValueType
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
   assert(index >= 0 && index <= GetSize() && index < GetMaxSize());
-  for (int i = GetSize(); i > index; i--) {
-    std::swap(array_[i], array_[i - 1]);
-  }
-  array_[index] = std::make_pair(key, value);
+  std::copy_backward(key_array_ + index, key_array_ + GetSize(), key_array_ + GetSize() + 1);
+  std::copy_backward(ValueArray() + index, ValueArray() + GetSize(), ValueArray() + GetSize() + 1);
+  key_array_[index] = key;
+  ValueArray()[index] = value;
   IncreaseSize(1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertFirstValue(const ValueType &value) {
   assert(GetSize() == 0);
-  array_[0] = std::make_pair(KeyType{}, value);
+  key_array_[0] = KeyType{};
+  ValueArray()[0] = value;
   IncreaseSize(1);
 }
 
@@ -92,53 +93,38 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveRightToHalf(B_PLUS_TREE_INTERNAL_PAGE_TYPE *recipient) {
   int n = GetSize();
   int mid = n / 2;
-  for (int i = mid, j = 0; i < n; i++, j++) {
-    std::swap(array_[i], recipient->array_[j]);
-  }
+  std::copy(key_array_ + mid, key_array_ + n, recipient->key_array_);
+  std::copy(ValueArray() + mid, ValueArray() + n, recipient->ValueArray());
   recipient->IncreaseSize(n - mid);
   IncreaseSize(-(n - mid));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &keyComparator) const -> int {
-  int left = 1;
-  int right = GetSize() - 1;
-  while (left <= right) {
-    int mid = (right - left) / 2 + left;
-    if (keyComparator(array_[mid].first, key) <= 0) {
-      left = mid + 1;
-    } else {
-      right = mid - 1;
-    }
-  }
-  return right;
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &keyComparator,
+                                            bool or_equal) const -> int {
+  // The first key is invalid; the last valid key <= key is just before the upper bound.
+  return GetSize() <= 1 ? 0 : KeyRank(key_array_ + 1, GetSize() - 1, key, keyComparator, or_equal);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToLastOf(B_PLUS_TREE_INTERNAL_PAGE_TYPE *recipient) {
-  recipient->array_[recipient->GetSize()] = EraseAt(0);
-  recipient->IncreaseSize(1);
+  auto [key, value] = EraseAt(0);
+  recipient->InsertAt(recipient->GetSize(), key, value);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFirstOf(B_PLUS_TREE_INTERNAL_PAGE_TYPE *recipient) {
-  MappingType tmp = EraseAt(GetSize() - 1);
-  for (int i = recipient->GetSize(); i > 0; i--) {
-    std::swap(recipient->array_[i], recipient->array_[i - 1]);
-  }
-  recipient->array_[0] = tmp;
-  recipient->IncreaseSize(1);
+  auto [key, value] = EraseAt(GetSize() - 1);
+  recipient->InsertAt(0, key, value);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllToEndOf(B_PLUS_TREE_INTERNAL_PAGE_TYPE *recipient) {
-  auto i = 0;
-  auto j = recipient->GetSize();
-  for (; i < GetSize(); i++, j++) {
-    std::swap(recipient->array_[j], array_[i]);
-  }
-  recipient->IncreaseSize(i);
-  IncreaseSize(-i);
+  int n = GetSize();
+  std::copy(key_array_, key_array_ + n, recipient->key_array_ + recipient->GetSize());
+  std::copy(ValueArray(), ValueArray() + n, recipient->ValueArray() + recipient->GetSize());
+  recipient->IncreaseSize(n);
+  IncreaseSize(-n);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -146,10 +132,9 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::EraseAt(int index) -> MappingType {
   if (index < 0 || index >= GetSize()) {
     return std::make_pair(KeyType{}, ValueType{});
   }
-  MappingType tmp = array_[index];
-  for (int i = index + 1; i < GetSize(); i++) {
-    std::swap(array_[i - 1], array_[i]);
-  }
+  MappingType tmp = std::make_pair(key_array_[index], ValueArray()[index]);
+  std::copy(key_array_ + index + 1, key_array_ + GetSize(), key_array_ + index);
+  std::copy(ValueArray() + index + 1, ValueArray() + GetSize(), ValueArray() + index);
   IncreaseSize(-1);
   return tmp;
 }
@@ -160,4 +145,11 @@ template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+
+// INTERNAL_PAGE_SIZE assumes the header is exactly INTERNAL_PAGE_HEADER_SIZE bytes whatever the page size.
+static_assert(sizeof(BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>) ==
+              INTERNAL_PAGE_HEADER_SIZE);
+static_assert(INTERNAL_PAGE_HEADER_SIZE + 3 * (sizeof(GenericKey<64>) + sizeof(page_id_t)) <= BUSTUB_PAGE_SIZE);
+// The page id array starts right after INTERNAL_PAGE_SIZE keys, which must keep it aligned.
+static_assert(sizeof(GenericKey<4>) % alignof(page_id_t) == 0 && INTERNAL_PAGE_HEADER_SIZE % alignof(page_id_t) == 0);
 }  // namespace bustub
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
@@ -51,23 +52,20 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   if (index < 0 || index >= GetSize()) {
     return KeyType{};
   }
-  return array_[index].first;
+  return key_array_[index];
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const
     -> std::pair<int, bool> {
-  int left = 0;
-  int right = GetSize() - 1;
-  while (left <= right) {
-    int mid = (right - left) / 2 + left;
-    if (comparator(array_[mid].first, key) >= 0) {
-      right = mid - 1;
-    } else {
-      left = mid + 1;
-    }
-  }
-  return std::make_pair(left, left >= GetSize() ? false : comparator(array_[left].first, key) == 0);
+  int index = KeyRank(key_array_, GetSize(), key, comparator, false);
+  return std::make_pair(index, index < GetSize() && comparator(key_array_[index], key) == 0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator, bool or_equal) const
+    -> int {
+  return KeyRank(key_array_, GetSize(), key, comparator, or_equal);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -75,7 +73,16 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
   if (index < 0 || index >= GetSize()) {
     return ValueType{};
   }
-  return array_[index].second;
+  return ValueArray()[index];
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  std::copy_backward(key_array_ + index, key_array_ + GetSize(), key_array_ + GetSize() + 1);
+  std::copy_backward(ValueArray() + index, ValueArray() + GetSize(), ValueArray() + GetSize() + 1);
+  key_array_[index] = key;
+  ValueArray()[index] = value;
+  IncreaseSize(1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -85,11 +92,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &val
   if (equal) {
     return false;
   }
-  for (int i = GetSize(); i > index; i--) {
-    std::swap(array_[i], array_[i - 1]);
-  }
-  array_[index] = std::make_pair(key, value);
-  IncreaseSize(1);
+  InsertAt(index, key, value);
   return true;
 }
 
@@ -99,49 +102,39 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Remove(const KeyType &key, const KeyComparator
   if (!equal) {
     return false;
   }
-  for (int i = index; i < GetSize() - 1; i++) {
-    std::swap(array_[i], array_[i + 1]);
-  }
-  IncreaseSize(-1);
+  EraseAt(index);
   return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveRightHalfTo(B_PLUS_TREE_LEAF_PAGE_TYPE *recipient) {
   int mid = GetSize() / 2;
-  int j = 0;
-  for (int i = mid; i < GetSize(); i++, j++) {
-    std::swap(array_[i], recipient->array_[j]);
-  }
-  IncreaseSize(-j);
-  recipient->IncreaseSize(j);
+  int n = GetSize() - mid;
+  std::copy(key_array_ + mid, key_array_ + GetSize(), recipient->key_array_ + recipient->GetSize());
+  std::copy(ValueArray() + mid, ValueArray() + GetSize(), recipient->ValueArray() + recipient->GetSize());
+  IncreaseSize(-n);
+  recipient->IncreaseSize(n);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToLastOf(B_PLUS_TREE_LEAF_PAGE_TYPE *recipient) {
-  recipient->array_[recipient->GetSize()] = EraseAt(0);
-  recipient->IncreaseSize(1);
+  auto [key, value] = EraseAt(0);
+  recipient->InsertAt(recipient->GetSize(), key, value);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFirstOf(B_PLUS_TREE_LEAF_PAGE_TYPE *recipient) {
-  MappingType tmp = EraseAt(GetSize() - 1);
-  for (int i = recipient->GetSize(); i > 0; i--) {
-    std::swap(recipient->array_[i], recipient->array_[i - 1]);
-  }
-  recipient->array_[0] = tmp;
-  recipient->IncreaseSize(1);
+  auto [key, value] = EraseAt(GetSize() - 1);
+  recipient->InsertAt(0, key, value);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllToEndOf(B_PLUS_TREE_LEAF_PAGE_TYPE *recipient) {
-  auto i = 0;
-  auto j = recipient->GetSize();
-  for (; i < GetSize(); i++, j++) {
-    std::swap(recipient->array_[j], array_[i]);
-  }
-  recipient->IncreaseSize(i);
-  IncreaseSize(-i);
+  int n = GetSize();
+  std::copy(key_array_, key_array_ + n, recipient->key_array_ + recipient->GetSize());
+  std::copy(ValueArray(), ValueArray() + n, recipient->ValueArray() + recipient->GetSize());
+  recipient->IncreaseSize(n);
+  IncreaseSize(-n);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -149,18 +142,17 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::EraseAt(int index) -> MappingType {
   if (index < 0 || index >= GetSize()) {
     return std::make_pair(KeyType{}, ValueType{});
   }
-  MappingType tmp = array_[index];
-  for (int i = index + 1; i < GetSize(); i++) {
-    std::swap(array_[i - 1], array_[i]);
-  }
+  MappingType tmp = std::make_pair(key_array_[index], ValueArray()[index]);
+  std::copy(key_array_ + index + 1, key_array_ + GetSize(), key_array_ + index);
+  std::copy(ValueArray() + index + 1, ValueArray() + GetSize(), ValueArray() + index);
   IncreaseSize(-1);
   return tmp;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ItemAt(int index) const -> const MappingType & {
-  assert(index >= 0 || index < GetSize());
-  return array_[index];
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ItemAt(int index) const -> MappingType {
+  assert(index >= 0 && index < GetSize());
+  return std::make_pair(key_array_[index], ValueArray()[index]);
 }
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
@@ -168,4 +160,10 @@ template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+// LEAF_PAGE_SIZE assumes the header is exactly LEAF_PAGE_HEADER_SIZE bytes whatever the page size.
+static_assert(sizeof(BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>) == LEAF_PAGE_HEADER_SIZE);
+static_assert(LEAF_PAGE_HEADER_SIZE + 2 * (sizeof(GenericKey<64>) + sizeof(RID)) <= BUSTUB_PAGE_SIZE);
+// The RID array starts right after LEAF_PAGE_SIZE keys, which must keep it aligned.
+static_assert(sizeof(GenericKey<4>) % alignof(RID) == 0 && LEAF_PAGE_HEADER_SIZE % alignof(RID) == 0);
 }  // namespace bustub
@@ -9,6 +9,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
@@ -40,4 +46,72 @@ void BPlusTreePage::SetMaxSize(int size) { max_size_ = size; }
  */
 auto BPlusTreePage::GetMinSize() const -> int { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
 
+/** Binary search stops once this few keys are left, which are then ranked all at once. */
+static constexpr int KEY_RANK_WINDOW = 16;
+
+/** A GenericKey<8> compares like the big-endian word it holds (see GenericKey). */
+static auto KeyWord(const GenericKey<8> &key) -> uint64_t {
+  uint64_t word = 0;
+  for (char byte : key.data_) {
+    word = (word << 8) | static_cast<uint8_t>(byte);
+  }
+  return word;
+}
+
+#if defined(__x86_64__)
+/** @return the number of keys whose word is less than bound */
+__attribute__((target("avx2"))) static auto CountBelowAvx2(const GenericKey<8> *keys, int size, uint64_t bound)
+    -> int {
+  // Byte-swap each 64-bit lane to get the words, and flip their sign bits so that a signed compare orders them.
+  const __m256i bswap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8);
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i target = _mm256_set1_epi64x(static_cast<int64_t>(bound ^ static_cast<uint64_t>(INT64_MIN)));
+  int count = 0;
+  int i = 0;
+  for (; i + 4 <= size; i += 4) {
+    __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+    words = _mm256_xor_si256(_mm256_shuffle_epi8(words, bswap), sign);
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target, words))));
+  }
+  for (; i < size; i++) {
+    count += KeyWord(keys[i]) < bound ? 1 : 0;
+  }
+  return count;
+}
+#endif
+
+template <>
+auto KeyRank(const GenericKey<8> *keys, int size, const GenericKey<8> &key, const GenericComparator<8> &comparator,
+             bool or_equal) -> int {
+  int left = 0;
+  int right = size;
+  while (right - left > KEY_RANK_WINDOW) {
+    int mid = (right - left) / 2 + left;
+    int cmp = comparator(keys[mid], key);
+    if (cmp < 0 || (or_equal && cmp == 0)) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  // Keys in [left, right) are sorted, so the rank within the window is the number of keys below the bound.
+  uint64_t word = KeyWord(key);
+  if (or_equal && word == UINT64_MAX) {
+    return right;
+  }
+  uint64_t bound = or_equal ? word + 1 : word;
+#if defined(__x86_64__)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_avx2) {
+    return left + CountBelowAvx2(keys + left, right - left, bound);
+  }
+#endif
+  int count = 0;
+  for (int i = left; i < right; i++) {
+    count += KeyWord(keys[i]) < bound ? 1 : 0;
+  }
+  return left + count;
+}
+
 }  // namespace bustub
@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.cpp
+//
+// Identification: src/storage/page/pax_table_page.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_table_page.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include "common/config.h"
+#include "common/exception.h"
+#include "common/macros.h"
+#include "type/type.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+PaxLayout::PaxLayout(const Schema &schema) : schema_(schema) {
+  // Start from the number of tuples that would fit if nothing had to be rounded up, and lower it until they do.
+  size_t tuple_bits = TUPLE_META_SIZE * 8;
+  size_t var_size = 0;
+  for (const auto &column : schema_.GetColumns()) {
+    if (column.IsInlined()) {
+      tuple_bits += Type::GetTypeSize(column.GetType()) * 8 + 1;
+    } else {
+      tuple_bits += sizeof(uint16_t) * 8 + 1;
+      var_size += std::min<size_t>(column.GetLength(), PAX_VARCHAR_SIZE_ESTIMATE) + sizeof(uint32_t);
+    }
+  }
+  tuple_bits += var_size * 8;
+  auto capacity = (BUSTUB_PAGE_SIZE - PAX_TABLE_PAGE_HEADER_SIZE) * 8 / tuple_bits;
+  while (capacity > 0 && LayOut(capacity) + capacity * var_size > BUSTUB_PAGE_SIZE) {
+    capacity--;
+  }
+  BUSTUB_ENSURE(capacity > 0, "tuples of this schema do not fit into a PAX page");
+  capacity_ = capacity;
+  columns_end_ = LayOut(capacity_);
+
+  std::vector<Value> nulls;
+  nulls.reserve(schema_.GetColumnCount());
+  for (const auto &column : schema_.GetColumns()) {
+    nulls.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+  }
+  Tuple null_tuple(std::move(nulls), &schema_);
+  null_tuple_.assign(null_tuple.GetData(), null_tuple.GetData() + schema_.GetLength());
+}
+
+auto PaxLayout::LayOut(uint16_t capacity) -> size_t {
+  columns_.clear();
+  size_t offset = PAX_TABLE_PAGE_HEADER_SIZE + TUPLE_META_SIZE * capacity;
+  for (const auto &column : schema_.GetColumns()) {
+    ColumnInfo info;
+    info.type_ = column.GetType();
+    info.width_ = column.IsInlined() ? Type::GetTypeSize(column.GetType()) : sizeof(uint16_t);
+    info.null_bitmap_offset_ = offset;
+    offset += (capacity + 7) / 8;
+    // Values are kept 8-byte aligned, so that they can be read in place.
+    offset = (offset + 7) & ~static_cast<size_t>(7);
+    info.values_offset_ = offset;
+    offset += static_cast<size_t>(info.width_) * capacity;
+    columns_.push_back(info);
+  }
+  return offset;
+}
+
+void PaxTablePage::Init(const PaxLayout &layout) {
+  next_page_id_ = INVALID_PAGE_ID;
+  num_tuples_ = 0;
+  num_deleted_tuples_ = 0;
+  var_data_size_ = 0;
+  capacity_ = layout.GetCapacity();
+}
+
+auto PaxTablePage::InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const std::vector<Value> &values)
+    -> std::optional<uint16_t> {
+  BUSTUB_ASSERT(values.size() == layout.columns_.size(), "a value is needed for each column");
+  if (num_tuples_ >= capacity_) {
+    return std::nullopt;
+  }
+  size_t var_size = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    if (layout.columns_[i].type_ == TypeId::VARCHAR && !values[i].IsNull()) {
+      var_size += values[i].GetLength() + sizeof(uint32_t);
+    }
+  }
+  if (layout.columns_end_ + var_data_size_ + var_size > BUSTUB_PAGE_SIZE) {
+    return std::nullopt;
+  }
+
+  auto tuple_id = num_tuples_++;
+  tuple_meta_[tuple_id] = meta;
+  if (meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  for (size_t i = 0; i < values.size(); i++) {
+    const auto &column = layout.columns_[i];
+    auto &null_bits = page_start_[column.null_bitmap_offset_ + tuple_id / 8];
+    auto null_bit = static_cast<char>(1 << (tuple_id % 8));
+    if (values[i].IsNull()) {
+      null_bits |= null_bit;
+      continue;
+    }
+    null_bits &= ~null_bit;
+    auto entry = page_start_ + column.values_offset_ + column.width_ * tuple_id;
+    if (column.type_ != TypeId::VARCHAR) {
+      values[i].SerializeTo(entry);
+      continue;
+    }
+    var_data_size_ += values[i].GetLength() + sizeof(uint32_t);
+    uint16_t offset = BUSTUB_PAGE_SIZE - var_data_size_;
+    values[i].SerializeTo(page_start_ + offset);
+    memcpy(entry, &offset, sizeof(offset));
+  }
+  return tuple_id;
+}
+
+void PaxTablePage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  if (!tuple_meta_[tuple_id].is_deleted_ && meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  tuple_meta_[tuple_id] = meta;
+}
+
+auto PaxTablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  return tuple_meta_[tuple_id];
+}
+
+auto PaxTablePage::GetValue(const PaxLayout &layout, uint16_t tuple_id, uint32_t column_idx) const -> Value {
+  const auto &column = layout.columns_[column_idx];
+  if (IsNull(column, tuple_id)) {
+    return ValueFactory::GetNullValueByType(column.type_);
+  }
+  if (column.type_ != TypeId::VARCHAR) {
+    return Value::DeserializeFrom(ValueAt(column, tuple_id), column.type_);
+  }
+  uint16_t offset;
+  memcpy(&offset, ValueAt(column, tuple_id), sizeof(offset));
+  return Value::DeserializeFrom(page_start_ + offset, TypeId::VARCHAR);
+}
+
+auto PaxTablePage::GetTuple(const PaxLayout &layout, const RID &rid) const -> std::pair<TupleMeta, Tuple> {
+  auto meta = GetTupleMeta(rid);
+  std::vector<Value> values;
+  values.reserve(layout.columns_.size());
+  for (uint32_t i = 0; i < layout.columns_.size(); i++) {
+    values.push_back(GetValue(layout, rid.GetSlotNum(), i));
+  }
+  Tuple tuple(std::move(values), &layout.GetSchema());
+  tuple.rid_ = rid;
+  return std::make_pair(meta, std::move(tuple));
+}
+
+void PaxTablePage::SerializeTuples(const PaxLayout &layout, uint16_t begin, uint16_t end,
+                                   const std::vector<uint32_t> &columns, std::vector<char> *data,
+                                   std::vector<uint32_t> *offsets) const {
+  const auto &schema = layout.GetSchema();
+  std::vector<bool> is_read(schema.GetColumnCount(), false);
+  for (auto column : columns) {
+    is_read[column] = true;
+  }
+  // A varchar is stored in the page as it is in a tuple, so its length is all that is needed to size the rows.
+  auto varchar_size = [&](uint32_t column, uint16_t tuple_id) -> uint32_t {
+    const auto &info = layout.columns_[column];
+    if (!is_read[column] || IsNull(info, tuple_id)) {
+      return sizeof(uint32_t);
+    }
+    uint16_t offset;
+    memcpy(&offset, ValueAt(info, tuple_id), sizeof(offset));
+    uint32_t length;
+    memcpy(&length, page_start_ + offset, sizeof(length));
+    return length + sizeof(uint32_t);
+  };
+
+  const auto &varchar_columns = schema.GetUnlinedColumns();
+  offsets->clear();
+  offsets->push_back(0);
+  for (auto tuple_id = begin; tuple_id < end; tuple_id++) {
+    uint32_t size = schema.GetLength();
+    for (auto column : varchar_columns) {
+      size += varchar_size(column, tuple_id);
+    }
+    offsets->push_back(offsets->back() + size);
+  }
+  data->resize(offsets->back());
+
+  // Start from null rows, whose varchars are filled in behind the fixed-length part.
+  for (auto tuple_id = begin; tuple_id < end; tuple_id++) {
+    auto row = data->data() + (*offsets)[tuple_id - begin];
+    memcpy(row, layout.null_tuple_.data(), schema.GetLength());
+    uint32_t row_offset = schema.GetLength();
+    for (auto column : varchar_columns) {
+      memcpy(row + schema.GetColumn(column).GetOffset(), &row_offset, sizeof(row_offset));
+      const auto &info = layout.columns_[column];
+      if (!is_read[column] || IsNull(info, tuple_id)) {
+        uint32_t null_length = BUSTUB_VALUE_NULL;
+        memcpy(row + row_offset, &null_length, sizeof(null_length));
+        row_offset += sizeof(null_length);
+        continue;
+      }
+      uint16_t offset;
+      memcpy(&offset, ValueAt(info, tuple_id), sizeof(offset));
+      auto size = varchar_size(column, tuple_id);
+      memcpy(row + row_offset, page_start_ + offset, size);
+      row_offset += size;
+    }
+  }
+
+  // Fixed-length values are stored in the page as they are in a tuple, and are copied a column at a time.
+  for (auto column : columns) {
+    if (!schema.GetColumn(column).IsInlined()) {
+      continue;
+    }
+    const auto &info = layout.columns_[column];
+    auto column_offset = schema.GetColumn(column).GetOffset();
+    for (auto tuple_id = begin; tuple_id < end; tuple_id++) {
+      if (!IsNull(info, tuple_id)) {
+        memcpy(data->data() + (*offsets)[tuple_id - begin] + column_offset, ValueAt(info, tuple_id), info.width_);
+      }
+    }
+  }
+}
+
+}  // namespace bustub
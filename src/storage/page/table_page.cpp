@@ -12,10 +12,12 @@
 
 #include "storage/page/table_page.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <optional>
 #include <tuple>
+#include <vector>
 #include "common/config.h"
 #include "common/exception.h"
 #include "storage/table/tuple.h"
@@ -26,33 +28,39 @@ void TablePage::Init() {
   next_page_id_ = INVALID_PAGE_ID;
   num_tuples_ = 0;
   num_deleted_tuples_ = 0;
+  tuple_data_size_ = 0;
+  num_free_slots_ = 0;
 }
 
-auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t> {
-  size_t slot_end_offset;
-  if (num_tuples_ > 0) {
-    auto &[offset, size, meta] = tuple_info_[num_tuples_ - 1];
-    slot_end_offset = offset;
-  } else {
-    slot_end_offset = BUSTUB_PAGE_SIZE;
-  }
-  auto tuple_offset = slot_end_offset - tuple.GetLength();
-  auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
-  if (tuple_offset < offset_size) {
+auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const TupleRef &tuple, bool reuse_free_slot) const
+    -> std::optional<uint16_t> {
+  // A free slot is reused, otherwise the tuple needs a new one.
+  auto needed = reuse_free_slot && num_free_slots_ > 0 ? tuple.GetLength() : SpaceFor(tuple.GetLength());
+  if (needed > GetFreeSpace()) {
     return std::nullopt;
   }
-  return tuple_offset;
+  return BUSTUB_PAGE_SIZE - tuple_data_size_ - tuple.GetLength();
 }
 
-auto TablePage::InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
-  auto tuple_offset = GetNextTupleOffset(meta, tuple);
+auto TablePage::InsertTuple(const TupleMeta &meta, const TupleRef &tuple, bool reuse_free_slot)
+    -> std::optional<uint16_t> {
+  auto tuple_offset = GetNextTupleOffset(meta, tuple, reuse_free_slot);
   if (tuple_offset == std::nullopt) {
     return std::nullopt;
   }
   auto tuple_id = num_tuples_;
+  if (reuse_free_slot && num_free_slots_ > 0) {
+    tuple_id = 0;
+    while (!IsFreeSlot(tuple_id)) {
+      tuple_id++;
+    }
+    num_free_slots_--;
+  } else {
+    num_tuples_++;
+  }
   tuple_info_[tuple_id] = std::make_tuple(*tuple_offset, tuple.GetLength(), meta);
-  num_tuples_++;
-  memcpy(page_start_ + *tuple_offset, tuple.data_.data(), tuple.GetLength());
+  tuple_data_size_ += tuple.GetLength();
+  memcpy(page_start_ + *tuple_offset, tuple.GetData(), tuple.GetLength());
   return tuple_id;
 }
 
@@ -69,16 +77,17 @@ void TablePage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
 }
 
 auto TablePage::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
+  auto [meta, tuple] = GetTupleRef(rid);
+  return std::make_pair(meta, Tuple(tuple));
+}
+
+auto TablePage::GetTupleRef(const RID &rid) const -> std::pair<TupleMeta, TupleRef> {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
     throw bustub::Exception("Tuple ID out of range");
   }
-  auto &[offset, size, meta] = tuple_info_[tuple_id];
-  Tuple tuple;
-  tuple.data_.resize(size);
-  memmove(tuple.data_.data(), page_start_ + offset, size);
-  tuple.rid_ = rid;
-  return std::make_pair(meta, std::move(tuple));
+  auto &meta = std::get<2>(tuple_info_[tuple_id]);
+  return std::make_pair(meta, TupleRef(page_start_ + GetOffset(tuple_id), GetSize(tuple_id), rid));
 }
 
 auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
@@ -95,15 +104,140 @@ void TablePage::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tup
   if (tuple_id >= num_tuples_) {
     throw bustub::Exception("Tuple ID out of range");
   }
-  auto &[offset, size, old_meta] = tuple_info_[tuple_id];
-  if (size != tuple.GetLength()) {
+  auto &old_meta = std::get<2>(tuple_info_[tuple_id]);
+  if (GetSize(tuple_id) != tuple.GetLength()) {
     throw bustub::Exception("Tuple size mismatch");
   }
   if (!old_meta.is_deleted_ && meta.is_deleted_) {
     num_deleted_tuples_++;
   }
-  tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
-  memcpy(page_start_ + offset, tuple.data_.data(), tuple.GetLength());
+  old_meta = meta;
+  memcpy(page_start_ + GetOffset(tuple_id), tuple.GetData(), tuple.GetLength());
+}
+
+auto TablePage::UpdateTupleInPlace(const TupleMeta &meta, const TupleRef &tuple, const RID &rid) -> bool {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  if (!PutData(tuple_id, tuple.GetData(), tuple.GetLength())) {
+    return false;
+  }
+  auto &[offset, size, old_meta] = tuple_info_[tuple_id];
+  if (!old_meta.is_deleted_ && meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  offset &= ~SLOT_FLAG;
+  old_meta = meta;
+  return true;
+}
+
+auto TablePage::SetForward(const TupleMeta &meta, const RID &rid, const RID &target) -> bool {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  auto address = target.Get();
+  if (!PutData(tuple_id, reinterpret_cast<const char *>(&address), sizeof(address))) {
+    return false;
+  }
+  auto &[offset, size, old_meta] = tuple_info_[tuple_id];
+  if (!old_meta.is_deleted_ && meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  offset |= SLOT_FLAG;
+  old_meta = meta;
+  return true;
+}
+
+auto TablePage::GetForward(const RID &rid) const -> std::optional<RID> {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  if ((std::get<0>(tuple_info_[tuple_id]) & SLOT_FLAG) == 0) {
+    return std::nullopt;
+  }
+  int64_t address;
+  memcpy(&address, page_start_ + GetOffset(tuple_id), sizeof(address));
+  return RID(address);
+}
+
+void TablePage::SetMoved(const RID &rid) {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  std::get<1>(tuple_info_[tuple_id]) |= SLOT_FLAG;
+}
+
+auto TablePage::PutData(uint16_t tuple_id, const char *data, uint16_t size) -> bool {
+  if (size <= GetSize(tuple_id)) {
+    // The bytes the data no longer needs stay a hole until the page is compacted.
+    memcpy(page_start_ + GetOffset(tuple_id), data, size);
+    SetData(tuple_id, GetOffset(tuple_id), size);
+    return true;
+  }
+  if (size > GetFreeSpace()) {
+    size_t used = 0;
+    for (uint16_t i = 0; i < num_tuples_; i++) {
+      used += i == tuple_id ? 0 : GetSize(i);
+    }
+    if (size > BUSTUB_PAGE_SIZE - TABLE_PAGE_HEADER_SIZE - TUPLE_INFO_SIZE * num_tuples_ - used) {
+      return false;
+    }
+    SetData(tuple_id, 0, 0);
+    Compact();
+  }
+  tuple_data_size_ += size;
+  auto offset = BUSTUB_PAGE_SIZE - tuple_data_size_;
+  memcpy(page_start_ + offset, data, size);
+  SetData(tuple_id, offset, size);
+  return true;
+}
+
+auto TablePage::Vacuum() -> uint32_t {
+  if (num_deleted_tuples_ == 0) {
+    return 0;
+  }
+  uint32_t removed = 0;
+  for (uint16_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+    auto meta = std::get<2>(tuple_info_[tuple_id]);
+    if (meta.is_deleted_ && !IsFreeSlot(tuple_id)) {
+      tuple_info_[tuple_id] = std::make_tuple(0, 0, meta);
+      num_free_slots_++;
+      removed++;
+    }
+  }
+  Compact();
+  num_deleted_tuples_ = 0;
+
+  // Free slots at the end are given back to the free space.
+  while (num_tuples_ > 0 && IsFreeSlot(num_tuples_ - 1)) {
+    num_tuples_--;
+    num_free_slots_--;
+  }
+  return removed;
+}
+
+void TablePage::Compact() {
+  // Move the tuples towards the end of the page, starting with the one closest to it. None of them moves down, so a
+  // tuple is never overwritten before it has been moved.
+  std::vector<uint16_t> tuple_ids;
+  for (uint16_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+    if (GetSize(tuple_id) > 0) {
+      tuple_ids.push_back(tuple_id);
+    }
+  }
+  std::sort(tuple_ids.begin(), tuple_ids.end(), [this](uint16_t a, uint16_t b) { return GetOffset(a) > GetOffset(b); });
+  size_t end = BUSTUB_PAGE_SIZE;
+  for (auto tuple_id : tuple_ids) {
+    auto size = GetSize(tuple_id);
+    end -= size;
+    memmove(page_start_ + end, page_start_ + GetOffset(tuple_id), size);
+    SetData(tuple_id, end, size);
+  }
+  tuple_data_size_ = BUSTUB_PAGE_SIZE - end;
 }
 
 }  // namespace bustub
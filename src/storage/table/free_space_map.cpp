@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+namespace bustub {
+
+void FreeSpaceMap::Update(page_id_t page_id, size_t free_space) {
+  Remove(page_id);
+  if (free_space > 0) {
+    free_space_.emplace(page_id, free_space);
+    pages_by_free_space_.emplace(free_space, page_id);
+  }
+}
+
+void FreeSpaceMap::Remove(page_id_t page_id) {
+  auto iter = free_space_.find(page_id);
+  if (iter == free_space_.end()) {
+    return;
+  }
+  pages_by_free_space_.erase({iter->second, page_id});
+  free_space_.erase(iter);
+}
+
+auto FreeSpaceMap::FindPage(size_t size) const -> std::optional<page_id_t> {
+  auto iter = pages_by_free_space_.lower_bound({size, INVALID_PAGE_ID});
+  if (iter == pages_by_free_space_.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+}  // namespace bustub
@@ -11,7 +11,9 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <functional>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "common/config.h"
@@ -21,103 +23,343 @@
 #include "concurrency/transaction.h"
 #include "fmt/format.h"
 #include "storage/page/page_guard.h"
+#include "storage/page/pax_table_page.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
+TableHeap::TableHeap(BufferPoolManager *bpm, size_t num_insert_pages) : bpm_(bpm), insert_pages_(num_insert_pages) {
+  CreateFirstPage();
+}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema &schema, TableStorage storage, size_t num_insert_pages)
+    : bpm_(bpm), insert_pages_(num_insert_pages) {
+  if (storage == TableStorage::Pax) {
+    pax_layout_.emplace(schema);
+  }
+  CreateFirstPage();
+}
+
+void TableHeap::CreateFirstPage() {
+  BUSTUB_ASSERT(!insert_pages_.empty(), "a table heap needs at least one insert page");
   // Initialize the first table page.
-  auto guard = bpm->NewPageGuarded(&first_page_id_);
+  auto guard = bpm_->NewPageGuarded(&first_page_id_);
   last_page_id_ = first_page_id_;
-  auto first_page = guard.AsMut<TablePage>();
+  auto first_page = guard.GetDataMut();
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init();
+  InitPage(first_page);
+  // All insert pages start out as the first page, and get pages of their own once it is full.
+  for (auto &insert_page : insert_pages_) {
+    insert_page.page_id_ = first_page_id_;
+  }
 }
 
-auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
-                            table_oid_t oid) -> std::optional<RID> {
-  std::unique_lock<std::mutex> guard(latch_);
-  auto page_guard = bpm_->FetchPageWrite(last_page_id_);
-  while (true) {
-    auto page = page_guard.AsMut<TablePage>();
-    if (page->GetNextTupleOffset(meta, tuple) != std::nullopt) {
-      break;
-    }
+void TableHeap::InitPage(char *page_data) const {
+  if (pax_layout_ != std::nullopt) {
+    reinterpret_cast<PaxTablePage *>(page_data)->Init(*pax_layout_);
+  } else {
+    reinterpret_cast<TablePage *>(page_data)->Init();
+  }
+}
 
-    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
-    BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
+auto TableHeap::GetNumTuples(const char *page_data) const -> uint32_t {
+  if (pax_layout_ != std::nullopt) {
+    return reinterpret_cast<const PaxTablePage *>(page_data)->GetNumTuples();
+  }
+  return reinterpret_cast<const TablePage *>(page_data)->GetNumTuples();
+}
 
-    page_id_t next_page_id = INVALID_PAGE_ID;
-    auto npg = bpm_->NewPage(&next_page_id);
-    BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
+auto TableHeap::GetNextPageId(const char *page_data) const -> page_id_t {
+  if (pax_layout_ != std::nullopt) {
+    return reinterpret_cast<const PaxTablePage *>(page_data)->GetNextPageId();
+  }
+  return reinterpret_cast<const TablePage *>(page_data)->GetNextPageId();
+}
 
-    page->SetNextPageId(next_page_id);
+auto TableHeap::InsertIntoPage(WritePageGuard *page_guard, const TupleMeta &meta, const TupleRef &tuple,
+                               bool reuse_free_slot) -> std::optional<uint16_t> {
+  if (pax_layout_ == std::nullopt) {
+    return page_guard->AsMut<TablePage>()->InsertTuple(meta, tuple, reuse_free_slot);
+  }
+  const auto &schema = pax_layout_->GetSchema();
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.push_back(tuple.GetValue(&schema, i));
+  }
+  return page_guard->AsMut<PaxTablePage>()->InsertTuple(*pax_layout_, meta, values);
+}
 
-    auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
-    next_page->Init();
+auto TableHeap::InsertTuple(const TupleMeta &meta, const TupleRef &tuple, LockManager *lock_mgr, Transaction *txn,
+                            table_oid_t oid) -> std::optional<RID> {
+  WritePageGuard page_guard;
+  auto rid = Insert(meta, tuple, &page_guard);
 
-    page_guard.Drop();
+  if (lock_mgr != nullptr) {
+    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, rid),
+                  "failed to lock when inserting new tuple");
+  }
+
+  page_guard.Drop();
 
-    // acquire latch here as TSAN complains. Given we only have one insertion thread, this is fine.
-    npg->WLatch();
-    auto next_page_guard = WritePageGuard{bpm_, npg};
+  return rid;
+}
 
-    last_page_id_ = next_page_id;
-    page_guard = std::move(next_page_guard);
+auto TableHeap::Insert(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard) -> RID {
+  // While a bounded scan is open, free space in the pages it may still reach is left alone, as the scan would see the
+  // tuple there.
+  if (num_open_scans_ > 0) {
+    return InsertIntoInsertPage(meta, tuple, page_guard, true);
   }
-  auto last_page_id = last_page_id_;
+  auto rid = InsertIntoFreeSpace(meta, tuple, page_guard);
+  if (rid == std::nullopt) {
+    rid = InsertIntoInsertPage(meta, tuple, page_guard, false);
+  }
+  return *rid;
+}
 
-  auto page = page_guard.AsMut<TablePage>();
-  auto slot_id = *page->InsertTuple(meta, tuple);
+auto TableHeap::InsertIntoFreeSpace(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard)
+    -> std::optional<RID> {
+  // What the free space map recorded may be out of date, so each page that is tried is recorded again with the space
+  // it really has.
+  while (true) {
+    std::optional<page_id_t> page_id;
+    {
+      std::scoped_lock<std::mutex> guard(free_space_latch_);
+      page_id = free_space_map_.FindPage(TablePage::SpaceFor(tuple.GetLength()));
+    }
+    if (page_id == std::nullopt) {
+      return std::nullopt;
+    }
+    *page_guard = bpm_->FetchPageWrite(*page_id);
+    auto page = page_guard->AsMut<TablePage>();
+    auto slot_id = page->InsertTuple(meta, tuple);
+    {
+      std::scoped_lock<std::mutex> guard(free_space_latch_);
+      free_space_map_.Update(*page_id, page->GetFreeSpace());
+    }
+    if (slot_id != std::nullopt) {
+      return RID(*page_id, *slot_id);
+    }
+    page_guard->Drop();
+  }
+}
 
-  // only allow one insertion at a time, otherwise it will deadlock.
-  guard.unlock();
+auto TableHeap::InsertIntoInsertPage(const TupleMeta &meta, const TupleRef &tuple, WritePageGuard *page_guard,
+                                     bool after_scans) -> RID {
+  auto &insert_page = insert_pages_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % insert_pages_.size()];
+  std::scoped_lock<std::mutex> insert_page_guard(insert_page.latch_);
+  *page_guard = bpm_->FetchPageWrite(insert_page.page_id_);
+  // Open scans stop at the page that was last when they began, so the pages appended after that are out of their reach.
+  bool is_usable = !after_scans || insert_page.page_number_ >= first_page_after_scans_;
+  auto slot_id = is_usable ? InsertIntoPage(page_guard, meta, tuple, true) : std::nullopt;
+  if (slot_id == std::nullopt) {
+    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
+    BUSTUB_ENSURE(!is_usable || GetNumTuples(page_guard->GetData()) != 0, "tuple is too large, cannot insert");
 
-  if (lock_mgr != nullptr) {
-    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{last_page_id, slot_id}),
-                  "failed to lock when inserting new tuple");
+    // Smaller tuples may still fit into the page that is left behind.
+    if (pax_layout_ == std::nullopt) {
+      std::scoped_lock<std::mutex> guard(free_space_latch_);
+      free_space_map_.Update(insert_page.page_id_, page_guard->As<TablePage>()->GetFreeSpace());
+    }
+    page_guard->Drop();
+
+    std::scoped_lock<std::mutex> guard(latch_);
+    *page_guard = AppendPage();
+    insert_page.page_id_ = page_guard->PageId();
+    insert_page.page_number_ = num_pages_ - 1;
+    slot_id = InsertIntoPage(page_guard, meta, tuple, true);
+    BUSTUB_ENSURE(slot_id != std::nullopt, "tuple is too large, cannot insert");
   }
+  return {insert_page.page_id_, *slot_id};
+}
 
-  page_guard.Drop();
+auto TableHeap::AppendPage() -> WritePageGuard {
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  auto npg = bpm_->NewPage(&next_page_id);
+  BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
+  InitPage(npg->GetData());
+  // Nobody else can reach the new page yet, so latching the last page while holding it cannot deadlock.
+  npg->WLatch();
+  auto next_page_guard = WritePageGuard{bpm_, npg};
 
-  return RID(last_page_id, slot_id);
+  auto last_page_guard = bpm_->FetchPageWrite(last_page_id_);
+  if (pax_layout_ != std::nullopt) {
+    last_page_guard.AsMut<PaxTablePage>()->SetNextPageId(next_page_id);
+  } else {
+    last_page_guard.AsMut<TablePage>()->SetNextPageId(next_page_id);
+  }
+  last_page_id_ = next_page_id;
+  num_pages_++;
+  return next_page_guard;
 }
 
 void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  if (pax_layout_ != std::nullopt) {
+    page_guard.AsMut<PaxTablePage>()->UpdateTupleMeta(meta, rid);
+    return;
+  }
   auto page = page_guard.AsMut<TablePage>();
   page->UpdateTupleMeta(meta, rid);
+  auto forward = page->GetForward(rid);
+
+  // The slots that vacuuming frees are only reused once no bounded scan is open, so it can run at any time.
+  auto deleted = page->GetNumDeletedTuples();
+  if (deleted > 0 && deleted * VACUUM_DELETED_FRACTION >= page->GetNumTuples()) {
+    TableVacuumStats stats;
+    VacuumPage(std::move(page_guard), &stats);
+  } else {
+    page_guard.Drop();
+  }
+
+  // A deleted tuple that was moved elsewhere is deleted there as well, so that vacuuming reclaims it.
+  if (forward != std::nullopt && meta.is_deleted_) {
+    UpdateTupleMeta(meta, *forward);
+  }
 }
 
-auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
-  auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+auto TableHeap::GetTuple(RID rid, AccessType access_type) -> std::pair<TupleMeta, Tuple> {
+  auto page_guard = bpm_->FetchPageRead(rid.GetPageId(), access_type);
+  if (pax_layout_ != std::nullopt) {
+    return page_guard.As<PaxTablePage>()->GetTuple(*pax_layout_, rid);
+  }
   auto page = page_guard.As<TablePage>();
   auto [meta, tuple] = page->GetTuple(rid);
+  auto forward = page->GetForward(rid);
+  if (forward == std::nullopt) {
+    return std::make_pair(meta, std::move(tuple));
+  }
+
+  // The forwarding slot stays latched while the moved tuple is read. An update changes the forward before it deletes
+  // the copy the forward led to, so that copy cannot be vacuumed, and its slot taken by another moved tuple, in the
+  // meantime. Writers latch one page at a time, apart from the new page AppendPage() links in, which nothing forwards
+  // to yet, so holding both latches cannot deadlock.
+  if (forward->GetPageId() == rid.GetPageId()) {
+    tuple = page->GetTuple(*forward).second;
+  } else {
+    auto moved_page_guard = bpm_->FetchPageRead(forward->GetPageId(), access_type);
+    tuple = moved_page_guard.As<TablePage>()->GetTuple(*forward).second;
+  }
   tuple.rid_ = rid;
   return std::make_pair(meta, std::move(tuple));
 }
 
 auto TableHeap::GetTupleMeta(RID rid) -> TupleMeta {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+  if (pax_layout_ != std::nullopt) {
+    return page_guard.As<PaxTablePage>()->GetTupleMeta(rid);
+  }
   auto page = page_guard.As<TablePage>();
   return page->GetTupleMeta(rid);
 }
 
-auto TableHeap::MakeIterator() -> TableIterator {
+auto TableHeap::MakeIterator(std::vector<uint32_t> columns) -> TableIterator {
   std::unique_lock<std::mutex> guard(latch_);
   auto last_page_id = last_page_id_;
   guard.unlock();
 
   auto page_guard = bpm_->FetchPageRead(last_page_id);
-  auto page = page_guard.As<TablePage>();
-  return {this, {first_page_id_, 0}, {last_page_id, page->GetNumTuples()}};
+  return {this, {first_page_id_, 0}, {last_page_id, GetNumTuples(page_guard.GetData())}, std::move(columns)};
 }
 
 auto TableHeap::MakeEagerIterator() -> TableIterator { return {this, {first_page_id_, 0}, {INVALID_PAGE_ID, 0}}; }
 
+auto TableHeap::Vacuum() -> TableVacuumStats {
+  TableVacuumStats stats;
+  auto page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    page_id = GetNextPageId(page_guard.GetData());
+    if (pax_layout_ != std::nullopt) {
+      stats.pages_++;
+      continue;
+    }
+    VacuumPage(std::move(page_guard), &stats);
+  }
+  return stats;
+}
+
+void TableHeap::VacuumPage(WritePageGuard page_guard, TableVacuumStats *stats) {
+  auto page_id = page_guard.PageId();
+  auto page = page_guard.AsMut<TablePage>();
+  auto removed = page->Vacuum();
+  auto free_space = page->GetFreeSpace();
+  page_guard.Drop();
+
+  stats->pages_++;
+  stats->tuples_removed_ += removed;
+  stats->free_bytes_ += free_space;
+  if (removed == 0) {
+    return;
+  }
+  stats->pages_vacuumed_++;
+  std::scoped_lock<std::mutex> guard(free_space_latch_);
+  free_space_map_.Update(page_id, free_space);
+}
+
+void TableHeap::BeginScan() {
+  num_open_scans_++;
+  // latch_ cannot be taken here, as the iterator holds the last page. A page appended meanwhile merely counts as one
+  // the scan may reach.
+  auto num_pages = num_pages_.load();
+  auto first_page = first_page_after_scans_.load();
+  while (first_page < num_pages && !first_page_after_scans_.compare_exchange_weak(first_page, num_pages)) {
+  }
+}
+
+void TableHeap::EndScan() { num_open_scans_--; }
+
+auto TableHeap::UpdateTuple(const TupleMeta &meta, const TupleRef &tuple, RID rid) -> bool {
+  if (pax_layout_ != std::nullopt) {
+    return false;
+  }
+  auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  auto page = page_guard.AsMut<TablePage>();
+  auto forward = page->GetForward(rid);
+  if (page->UpdateTupleInPlace(meta, tuple, rid)) {
+    page_guard.Drop();
+    // The tuple is back in its own slot, so its moved copy is no longer needed.
+    if (forward != std::nullopt) {
+      UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, *forward);
+    }
+    return true;
+  }
+  page_guard.Drop();
+
+  // A tuple that was moved before is updated where it is if it still fits there.
+  if (forward != std::nullopt) {
+    auto moved_page_guard = bpm_->FetchPageWrite(forward->GetPageId());
+    if (moved_page_guard.AsMut<TablePage>()->UpdateTupleInPlace(meta, tuple, *forward)) {
+      return true;
+    }
+  }
+
+  // Otherwise, it is moved to another page, and its slot forwards to it.
+  WritePageGuard moved_page_guard;
+  auto moved_rid = Insert(meta, tuple, &moved_page_guard);
+  moved_page_guard.AsMut<TablePage>()->SetMoved(moved_rid);
+  moved_page_guard.Drop();
+
+  page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  if (!page_guard.AsMut<TablePage>()->SetForward(meta, rid, moved_rid)) {
+    page_guard.Drop();
+    UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, moved_rid);
+    return false;
+  }
+  page_guard.Drop();
+  if (forward != std::nullopt) {
+    UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, *forward);
+  }
+  return true;
+}
+
 void TableHeap::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  if (pax_layout_ != std::nullopt) {
+    throw NotImplementedException("tuples of a PAX table cannot be updated in place");
+  }
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
   auto page = page_guard.AsMut<TablePage>();
   page->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
@@ -10,61 +10,180 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <numeric>
 #include <optional>
+#include <utility>
 
 #include "common/config.h"
 #include "common/exception.h"
 #include "concurrency/transaction.h"
+#include "storage/page/pax_table_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid)
-    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid) {
-  // If the rid doesn't correspond to a tuple (i.e., the table has just been initialized), then
-  // we set rid_ to invalid.
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  if (rid_.GetSlotNum() >= page->GetNumTuples()) {
-    rid_ = RID{INVALID_PAGE_ID, 0};
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid, std::vector<uint32_t> columns)
+    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid), columns_(std::move(columns)) {
+  if (stop_at_rid_.GetPageId() != INVALID_PAGE_ID) {
+    table_heap_->BeginScan();
+    is_registered_ = true;
+  }
+  LoadPage(rid);
+}
+
+TableIterator::TableIterator(TableIterator &&other) noexcept
+    : table_heap_(other.table_heap_),
+      rid_(other.rid_),
+      stop_at_rid_(other.stop_at_rid_),
+      is_registered_(std::exchange(other.is_registered_, false)),
+      columns_(std::move(other.columns_)),
+      page_(std::move(other.page_)),
+      batch_page_(std::move(other.batch_page_)),
+      owned_(std::move(other.owned_)),
+      batch_owned_(std::move(other.batch_owned_)),
+      rows_(std::move(other.rows_)),
+      batch_rows_(std::move(other.batch_rows_)),
+      row_offsets_(std::move(other.row_offsets_)),
+      batch_(std::move(other.batch_)),
+      batch_index_(other.batch_index_),
+      next_rid_(other.next_rid_),
+      pages_until_read_ahead_(other.pages_until_read_ahead_) {}
+
+TableIterator::~TableIterator() {
+  if (is_registered_) {
+    table_heap_->EndScan();
   }
 }
 
-auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> { return table_heap_->GetTuple(rid_); }
+auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> {
+  const auto &[meta, tuple] = batch_[batch_index_];
+  return std::make_pair(meta, Tuple(tuple));
+}
 
 auto TableIterator::GetRID() -> RID { return rid_; }
 
 auto TableIterator::IsEnd() -> bool { return rid_.GetPageId() == INVALID_PAGE_ID; }
 
 auto TableIterator::operator++() -> TableIterator & {
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  auto next_tuple_id = rid_.GetSlotNum() + 1;
+  BUSTUB_ASSERT(!IsEnd(), "iterate out of bound");
+  if (++batch_index_ < batch_.size()) {
+    rid_ = batch_[batch_index_].second.GetRid();
+  } else {
+    LoadPage(next_rid_);
+  }
+  return *this;
+}
 
-  if (stop_at_rid_.GetPageId() != INVALID_PAGE_ID) {
-    BUSTUB_ASSERT(
-        /* case 1: cursor before the page of the stop tuple */ rid_.GetPageId() < stop_at_rid_.GetPageId() ||
-            /* case 2: cursor at the page before the tuple */
-            (rid_.GetPageId() == stop_at_rid_.GetPageId() && next_tuple_id <= stop_at_rid_.GetSlotNum()),
-        "iterate out of bound");
+auto TableIterator::NextBatch() -> std::vector<std::pair<TupleMeta, TupleRef>> {
+  if (IsEnd()) {
+    return {};
   }
+  auto batch = std::move(batch_);
+  batch.erase(batch.begin(), batch.begin() + batch_index_);
+  // Swapping keeps the bytes the batch points to where they are, and loads the next page into the other buffer.
+  std::swap(page_, batch_page_);
+  std::swap(owned_, batch_owned_);
+  std::swap(rows_, batch_rows_);
+  LoadPage(next_rid_);
+  return batch;
+}
 
-  rid_ = RID{rid_.GetPageId(), next_tuple_id};
+void TableIterator::LoadPage(RID rid) {
+  batch_.clear();
+  batch_index_ = 0;
+  while (rid.GetPageId() != INVALID_PAGE_ID) {
+    auto page_id = rid.GetPageId();
+    auto page_guard = table_heap_->bpm_->FetchPageRead(page_id, AccessType::Scan);
+    page_.resize(BUSTUB_PAGE_SIZE);
+    memcpy(page_.data(), page_guard.GetData(), BUSTUB_PAGE_SIZE);
+    page_guard.Drop();
 
-  if (rid_ == stop_at_rid_) {
-    rid_ = RID{INVALID_PAGE_ID, 0};
-  } else if (next_tuple_id < page->GetNumTuples()) {
-    // that's fine
-  } else {
-    auto next_page_id = page->GetNextPageId();
-    // if next page is invalid, RID is set to invalid page; otherwise, it's the first tuple in that page.
-    rid_ = RID{next_page_id, 0};
+    uint32_t end_slot = table_heap_->GetNumTuples(page_.data());
+    if (page_id == stop_at_rid_.GetPageId()) {
+      end_slot = std::min(end_slot, stop_at_rid_.GetSlotNum());
+    }
+    if (table_heap_->pax_layout_ != std::nullopt) {
+      LoadPaxTuples(page_id, rid.GetSlotNum(), end_slot);
+    } else {
+      auto page = reinterpret_cast<const TablePage *>(page_.data());
+      std::vector<size_t> forwarded;
+      for (auto slot = rid.GetSlotNum(); slot < end_slot; slot++) {
+        RID slot_rid{page_id, slot};
+        // A moved tuple is seen through the slot that forwards to it, and a freed slot has no tuple to see.
+        if (page->IsMoved(slot_rid) || page->IsFree(slot_rid)) {
+          continue;
+        }
+        if (page->GetForward(slot_rid) != std::nullopt && !page->GetTupleMeta(slot_rid).is_deleted_) {
+          forwarded.push_back(batch_.size());
+        }
+        batch_.push_back(page->GetTupleRef(slot_rid));
+      }
+      owned_.clear();
+      owned_.reserve(forwarded.size());
+      for (auto i : forwarded) {
+        auto &tuple = batch_[i].second;
+        owned_.push_back(table_heap_->GetTuple(tuple.GetRid(), AccessType::Scan).second);
+        tuple = owned_.back();
+      }
+    }
+    auto next_page_id = table_heap_->GetNextPageId(page_.data());
+
+    RID next_rid{INVALID_PAGE_ID, 0};
+    if (stop_at_rid_.GetPageId() == INVALID_PAGE_ID) {
+      // An eager scan also sees tuples inserted later, so it looks at the page again once it is done with these.
+      next_rid = batch_.empty() ? RID{next_page_id, 0} : RID{page_id, end_slot};
+    } else if (page_id != stop_at_rid_.GetPageId()) {
+      // While the scan is open, tuples are only appended to the last page, so the pages before the stop page only lose
+      // tuples.
+      next_rid = RID{next_page_id, 0};
+    }
+
+    if (next_rid.GetPageId() != INVALID_PAGE_ID && next_rid.GetPageId() != page_id) {
+      ReadAhead(next_rid.GetPageId());
+    }
+    if (!batch_.empty()) {
+      rid_ = batch_.front().second.GetRid();
+      next_rid_ = next_rid;
+      return;
+    }
+    rid = next_rid;
   }
+  rid_ = RID{INVALID_PAGE_ID, 0};
+}
 
-  page_guard.Drop();
+void TableIterator::LoadPaxTuples(page_id_t page_id, uint32_t begin, uint32_t end) {
+  const auto &layout = *table_heap_->pax_layout_;
+  auto page = reinterpret_cast<const PaxTablePage *>(page_.data());
+  end = std::max(begin, end);
 
-  return *this;
+  if (columns_.empty()) {
+    std::vector<uint32_t> columns(layout.GetSchema().GetColumnCount());
+    std::iota(columns.begin(), columns.end(), 0);
+    page->SerializeTuples(layout, begin, end, columns, &rows_, &row_offsets_);
+  } else {
+    page->SerializeTuples(layout, begin, end, columns_, &rows_, &row_offsets_);
+  }
+  for (auto slot = begin; slot < end; slot++) {
+    RID rid{page_id, slot};
+    auto i = slot - begin;
+    batch_.emplace_back(page->GetTupleMeta(rid),
+                        TupleRef(rows_.data() + row_offsets_[i], row_offsets_[i + 1] - row_offsets_[i], rid));
+  }
+}
+
+void TableIterator::ReadAhead(page_id_t page_id) {
+  if (pages_until_read_ahead_ > 0) {
+    pages_until_read_ahead_--;
+    return;
+  }
+  // Keep the next READ_AHEAD_PAGES pages in flight, topping the window up every half window.
+  table_heap_->bpm_->PrefetchChain(page_id, READ_AHEAD_PAGES, [table_heap = table_heap_](const char *data) {
+    return table_heap->GetNextPageId(data);
+  });
+  pages_until_read_ahead_ = READ_AHEAD_PAGES / 2;
 }
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/table/tuple.h"
@@ -35,8 +36,8 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   }
 
   // 2. Allocate memory.
-  data_.resize(tuple_size);
-  std::fill(data_.begin(), data_.end(), 0);
+  buffer_.resize(tuple_size);
+  std::fill(buffer_.begin(), buffer_.end(), 0);
 
   // 3. Serialize each attribute based on the input value.
   uint32_t column_count = schema->GetColumnCount();
@@ -46,21 +47,60 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
     const auto &col = schema->GetColumn(i);
     if (!col.IsInlined()) {
       // Serialize relative offset, where the actual varchar data is stored.
-      *reinterpret_cast<uint32_t *>(data_.data() + col.GetOffset()) = offset;
+      *reinterpret_cast<uint32_t *>(buffer_.data() + col.GetOffset()) = offset;
       // Serialize varchar value, in place (size+data).
-      values[i].SerializeTo(data_.data() + offset);
+      values[i].SerializeTo(buffer_.data() + offset);
       auto len = values[i].GetLength();
       if (len == BUSTUB_VALUE_NULL) {
         len = 0;
       }
       offset += (len + sizeof(uint32_t));
     } else {
-      values[i].SerializeTo(data_.data() + col.GetOffset());
+      values[i].SerializeTo(buffer_.data() + col.GetOffset());
     }
   }
+  Bind();
 }
 
-auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+Tuple::Tuple(const TupleRef &other) : TupleRef(other), buffer_(other.GetData(), other.GetData() + other.GetLength()) {
+  Bind();
+}
+
+Tuple::Tuple(Tuple &&other) noexcept : TupleRef(other), buffer_(std::move(other.buffer_)) {
+  other.data_ = nullptr;
+  other.length_ = 0;
+}
+
+auto Tuple::operator=(const Tuple &other) -> Tuple & {
+  if (this != &other) {
+    *this = static_cast<const TupleRef &>(other);
+  }
+  return *this;
+}
+
+auto Tuple::operator=(const TupleRef &other) -> Tuple & {
+  rid_ = other.GetRid();
+  if (other.GetData() != data_) {
+    // Reuses the buffer, so that a tuple that is assigned row after row only allocates when a row outgrows it.
+    buffer_.assign(other.GetData(), other.GetData() + other.GetLength());
+    Bind();
+  }
+  return *this;
+}
+
+auto Tuple::operator=(Tuple &&other) noexcept -> Tuple & {
+  if (this != &other) {
+    buffer_ = std::move(other.buffer_);
+    data_ = other.data_;
+    length_ = other.length_;
+    rid_ = other.rid_;
+    other.data_ = nullptr;
+    other.length_ = 0;
+  }
+  return *this;
+}
+
+auto TupleRef::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
   assert(schema);
   const TypeId column_type = schema->GetColumn(column_idx).GetType();
   const char *data_ptr = GetDataPtr(schema, column_idx);
@@ -68,8 +108,8 @@ auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> V
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
-auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
-    -> Tuple {
+auto TupleRef::KeyFromTuple(const Schema &schema, const Schema &key_schema,
+                            const std::vector<uint32_t> &key_attrs) const -> Tuple {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
   for (auto idx : key_attrs) {
@@ -78,21 +118,21 @@ auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const s
   return {values, &key_schema};
 }
 
-auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
+auto TupleRef::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
   assert(schema);
   const auto &col = schema->GetColumn(column_idx);
   bool is_inlined = col.IsInlined();
   // For inline type, data is stored where it is.
   if (is_inlined) {
-    return (data_.data() + col.GetOffset());
+    return (data_ + col.GetOffset());
   }
   // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
+  int32_t offset = *reinterpret_cast<const int32_t *>(data_ + col.GetOffset());
   // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
+  return (data_ + offset);
 }
 
-auto Tuple::ToString(const Schema *schema) const -> std::string {
+auto TupleRef::ToString(const Schema *schema) const -> std::string {
   std::stringstream os;
 
   int column_count = schema->GetColumnCount();
@@ -112,21 +152,22 @@ auto Tuple::ToString(const Schema *schema) const -> std::string {
     }
   }
   os << ")";
-  os << " Tuple size is " << data_.size();
+  os << " Tuple size is " << length_;
 
   return os.str();
 }
 
-void Tuple::SerializeTo(char *storage) const {
-  int32_t sz = data_.size();
+void TupleRef::SerializeTo(char *storage) const {
+  int32_t sz = length_;
   memcpy(storage, &sz, sizeof(int32_t));
-  memcpy(storage + sizeof(int32_t), data_.data(), sz);
+  memcpy(storage + sizeof(int32_t), data_, sz);
 }
 
 void Tuple::DeserializeFrom(const char *storage) {
   uint32_t size = *reinterpret_cast<const uint32_t *>(storage);
-  this->data_.resize(size);
-  memcpy(this->data_.data(), storage + sizeof(int32_t), size);
+  this->buffer_.resize(size);
+  memcpy(this->buffer_.data(), storage + sizeof(int32_t), size);
+  Bind();
 }
 
 }  // namespace bustub
@@ -12,11 +12,14 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -144,4 +147,334 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Check that a slow read of one page does not block fetches of pages that are already in the pool
+TEST(BufferPoolManagerTest, HitDuringSlowMissTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t cold_page_id;
+  page_id_t hot_page_id;
+  auto *cold_page = bpm->NewPage(&cold_page_id);
+  snprintf(cold_page->GetData(), BUSTUB_PAGE_SIZE, "cold");
+  bpm->UnpinPage(cold_page_id, true);
+  bpm->FlushPage(cold_page_id);
+  bpm->DeletePage(cold_page_id);
+
+  auto *hot_page = bpm->NewPage(&hot_page_id);
+  snprintf(hot_page->GetData(), BUSTUB_PAGE_SIZE, "hot");
+  bpm->UnpinPage(hot_page_id, true);
+
+  disk_manager->SetLatency(1000);
+
+  // Scenario: two threads miss on the same page. Both must see the data once, and only after the read completes.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&]() {
+      auto *page = bpm->FetchPage(cold_page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), "cold"));
+      bpm->UnpinPage(cold_page_id, false);
+    });
+  }
+
+  // Scenario: while the cold read is in flight, the cached page can be fetched without waiting for the disk.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto *page = bpm->FetchPage(hot_page_id);
+  auto hit_latency = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+  EXPECT_LT(hit_latency, std::chrono::milliseconds(900));
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  // Scenario: both readers have released their pins on the shared frame.
+  cold_page = bpm->FetchPage(cold_page_id);
+  EXPECT_EQ(1, cold_page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(cold_page_id, false));
+}
+
+// NOLINTNEXTLINE
+// Check that a slow flush of one page does not block fetches of other pages
+TEST(BufferPoolManagerTest, HitDuringSlowFlushTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t flushed_page_id;
+  page_id_t hot_page_id;
+  auto *flushed_page = bpm->NewPage(&flushed_page_id);
+  snprintf(flushed_page->GetData(), BUSTUB_PAGE_SIZE, "flushed");
+  bpm->UnpinPage(flushed_page_id, true);
+  auto *hot_page = bpm->NewPage(&hot_page_id);
+  snprintf(hot_page->GetData(), BUSTUB_PAGE_SIZE, "hot");
+  bpm->UnpinPage(hot_page_id, true);
+
+  disk_manager->SetLatency(1000);
+  auto start = std::chrono::steady_clock::now();
+  std::thread flusher([&]() { EXPECT_TRUE(bpm->FlushPage(flushed_page_id)); });
+
+  // Scenario: while the flush is in flight, the cached page can be fetched without waiting for the disk.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto *page = bpm->FetchPage(hot_page_id);
+  auto hit_latency = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+  EXPECT_LT(hit_latency, std::chrono::milliseconds(900));
+
+  // Scenario: once the flush is done, only the page that was not flushed is dirty.
+  flusher.join();
+  EXPECT_EQ(1, bpm->GetDirtyCount());
+  disk_manager->SetLatency(0);
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager->ReadPage(flushed_page_id, data);
+  EXPECT_EQ(0, strcmp(data, "flushed"));
+}
+
+// NOLINTNEXTLINE
+// Check that a sharded pool keeps every page's content while threads churn through different shards
+TEST(BufferPoolManagerTest, ShardedConcurrencyTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_shards = 4;
+  const size_t k = 2;
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+  EXPECT_EQ(num_shards, bpm->GetNumShards());
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&bpm, tid]() {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        auto guard = bpm->NewPageGuarded(&page_id);
+        snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "%d", page_id * num_threads + tid);
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        auto guard = bpm->FetchPageRead(page_id);
+        EXPECT_EQ(std::to_string(page_id * num_threads + tid), std::string(guard.GetData()));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that a new page goes to another shard when its own is full, and that no page id is skipped for good
+TEST(BufferPoolManagerTest, ShardedNewPageTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_shards = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+
+  page_id_t page_id;
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(i, page_id);
+  }
+
+  // Scenario: page 4 belongs to the first shard, which is pinned, so the new page is placed in the second one.
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(5, page_id);
+
+  // Scenario: a pool with every frame pinned fails without using up page ids.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  // Scenario: the skipped id is handed out once its shard has room.
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(4, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(6, page_id);
+}
+
+// NOLINTNEXTLINE
+// Check that prefetched pages are served from the pool afterwards
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Scenario: write a chain of pages, each page storing the id of the next one, then drop them from the pool.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    page_ids.push_back(page_id);
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto next_page_id = i + 1 < buffer_pool_size ? page_ids[i + 1] : INVALID_PAGE_ID;
+    memcpy(bpm->FetchPage(page_ids[i])->GetData(), &next_page_id, sizeof(page_id_t));
+    bpm->UnpinPage(page_ids[i], true);
+    bpm->UnpinPage(page_ids[i], true);
+    bpm->FlushPage(page_ids[i]);
+    bpm->DeletePage(page_ids[i]);
+  }
+
+  // Scenario: prefetch the first half by id and the second half by following the chain.
+  const size_t half = buffer_pool_size / 2;
+  bpm->PrefetchPages({page_ids.begin(), page_ids.begin() + half});
+  bpm->PrefetchChain(page_ids[half], buffer_pool_size, [](const char *data) {
+    return *reinterpret_cast<const page_id_t *>(data);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(page_ids[i], AccessType::Get);
+    ASSERT_NE(nullptr, page);
+    auto next_page_id = i + 1 < buffer_pool_size ? page_ids[i + 1] : INVALID_PAGE_ID;
+    EXPECT_EQ(next_page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_ids[i], false);
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetHitCount(AccessType::Get));
+  EXPECT_EQ(0, bpm->GetMissCount(AccessType::Get));
+}
+
+// NOLINTNEXTLINE
+// Check that the background flusher cleans unpinned pages and that a checkpoint does not stall cached fetches
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Scenario: fill the pool with dirty pages and keep the last one pinned.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  for (size_t i = 0; i + 1 < buffer_pool_size; i++) {
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetDirtyCount());
+
+  // Scenario: the flusher writes back unpinned pages until at most a quarter of the pool is dirty.
+  bpm->StartBackgroundFlusher(0.25, std::chrono::milliseconds(1));
+  for (int i = 0; i < 100 && bpm->GetDirtyCount() > buffer_pool_size / 4; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopBackgroundFlusher();
+  EXPECT_LE(bpm->GetDirtyCount(), buffer_pool_size / 4);
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager->ReadPage(page_ids[0], data);
+  EXPECT_EQ("page " + std::to_string(page_ids[0]), std::string(data));
+
+  // Scenario: cleaned pages stay cached and evicting them needs no write.
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_FALSE(page->IsDirty());
+  EXPECT_EQ(1, page->GetPinCount());
+  bpm->UnpinPage(page_ids[0], false);
+
+  // Scenario: while a slow checkpoint is running, a cached page can still be fetched.
+  disk_manager->SetLatency(100);
+  auto start = std::chrono::steady_clock::now();
+  std::thread checkpoint([&]() { bpm->FlushAllPages(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  page = bpm->FetchPage(page_ids[1]);
+  auto hit_latency = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(nullptr, page);
+  EXPECT_LT(hit_latency, std::chrono::milliseconds(500));
+  bpm->UnpinPage(page_ids[1], false);
+  checkpoint.join();
+  disk_manager->SetLatency(0);
+
+  // Scenario: after the checkpoint every page, including the pinned one, is on disk and clean.
+  EXPECT_EQ(0, bpm->GetDirtyCount());
+  disk_manager->ReadPage(page_ids.back(), data);
+  EXPECT_EQ("page " + std::to_string(page_ids.back()), std::string(data));
+  bpm->UnpinPage(page_ids.back(), false);
+}
+
+// NOLINTNEXTLINE
+// Check that each pass of the background flusher only looks at the frames closest to eviction
+TEST(BufferPoolManagerTest, BackgroundFlushScanLimitTest) {
+  const size_t buffer_pool_size = 2 * FLUSH_SCAN_FRAMES;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Scenario: fill the pool with dirty, unpinned pages, the first ones created being the first to be evicted.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the flusher cleans the frames it looks at, and leaves the ones further back dirty.
+  bpm->StartBackgroundFlusher(0, std::chrono::milliseconds(1));
+  for (int i = 0; i < 100 && bpm->GetDirtyCount() > buffer_pool_size - FLUSH_SCAN_FRAMES; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  bpm->StopBackgroundFlusher();
+  EXPECT_EQ(buffer_pool_size - FLUSH_SCAN_FRAMES, bpm->GetDirtyCount());
+  auto *page = bpm->FetchPage(page_ids[0]);
+  EXPECT_FALSE(page->IsDirty());
+  bpm->UnpinPage(page_ids[0], false);
+  page = bpm->FetchPage(page_ids.back());
+  EXPECT_TRUE(page->IsDirty());
+  bpm->UnpinPage(page_ids.back(), false);
+}
+
+// NOLINTNEXTLINE
+// Check that frames held in a huge-page arena are page-aligned and keep their data across eviction
+TEST(BufferPoolManagerTest, FrameArenaTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_shards = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards,
+                                                 FrameArenaOptions{true, NumaPolicy::Interleave});
+
+  // Scenario: write twice as many pages as there are frames, so that half of them are evicted.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % BUSTUB_PAGE_SIZE);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page->GetData()[BUSTUB_PAGE_SIZE - 1] = 'x';
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  for (auto page_id : page_ids) {
+    auto guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(guard.GetData()));
+    EXPECT_EQ('x', guard.GetData()[BUSTUB_PAGE_SIZE - 1]);
+  }
+}
+
 }  // namespace bustub
@@ -95,4 +95,98 @@ TEST(LRUKReplacerTest, SampleTest) {
   ASSERT_EQ(false, lru_replacer.Evict(&value));
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+// Compare the replacer against a straightforward model of LRU-K on a random workload.
+TEST(LRUKReplacerTest, RandomWorkloadTest) {
+  const size_t num_frames = 64;
+  const size_t k = 3;
+  LRUKReplacer lru_replacer(num_frames, k);
+
+  std::vector<std::vector<size_t>> history(num_frames);
+  std::vector<bool> evictable(num_frames, false);
+  size_t timestamp = 0;
+
+  auto expected_victim = [&]() {
+    frame_id_t victim = -1;
+    bool victim_inf = false;
+    size_t victim_ts = 0;
+    for (size_t fid = 0; fid < num_frames; fid++) {
+      if (!evictable[fid] || history[fid].empty()) {
+        continue;
+      }
+      bool inf = history[fid].size() < k;
+      size_t ts = history[fid][history[fid].size() < k ? 0 : history[fid].size() - k];
+      if (victim == -1 || (inf && !victim_inf) || (inf == victim_inf && ts < victim_ts)) {
+        victim = fid;
+        victim_inf = inf;
+        victim_ts = ts;
+      }
+    }
+    return victim;
+  };
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, num_frames - 1);
+  std::uniform_int_distribution<int> op_dist(0, 9);
+  for (int i = 0; i < 20000; i++) {
+    auto fid = frame_dist(gen);
+    auto op = op_dist(gen);
+    if (op < 5) {
+      lru_replacer.RecordAccess(fid);
+      history[fid].push_back(++timestamp);
+    } else if (op < 8) {
+      bool set_evictable = op < 7;
+      lru_replacer.SetEvictable(fid, set_evictable);
+      if (!history[fid].empty()) {
+        evictable[fid] = set_evictable;
+      }
+    } else if (op < 9) {
+      auto victim = expected_victim();
+      frame_id_t value;
+      ASSERT_EQ(victim != -1, lru_replacer.Evict(&value));
+      if (victim != -1) {
+        ASSERT_EQ(victim, value);
+        history[victim].clear();
+        evictable[victim] = false;
+      }
+    } else if (evictable[fid]) {
+      lru_replacer.Remove(fid);
+      history[fid].clear();
+      evictable[fid] = false;
+    }
+    ASSERT_EQ(std::count(evictable.begin(), evictable.end(), true), lru_replacer.Size());
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that frames brought in by a scan are evicted before the working set, however recently they were accessed
+TEST(LRUKReplacerTest, ScanAccessTest) {
+  LRUKReplacer lru_replacer(6, 2);
+
+  // Scenario: frames 0 and 1 belong to the working set, frames 2, 3 and 4 are brought in by a scan.
+  lru_replacer.RecordAccess(0, AccessType::Get);
+  lru_replacer.RecordAccess(0, AccessType::Get);
+  lru_replacer.RecordAccess(1, AccessType::Get);
+  lru_replacer.RecordAccess(2, AccessType::Scan);
+  lru_replacer.RecordAccess(3, AccessType::Scan);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  for (frame_id_t fid = 0; fid < 5; fid++) {
+    lru_replacer.SetEvictable(fid, true);
+  }
+
+  // Scenario: the scan passes over frame 1 and frame 3 is used by a regular access. Neither stays a scan frame,
+  // and frame 1 keeps its place.
+  lru_replacer.RecordAccess(1, AccessType::Scan);
+  lru_replacer.RecordAccess(3, AccessType::Get);
+
+  // Scan-only frames go first, then frames with fewer than k accesses, then the rest. The scan access still counts
+  // towards frame 3's history, so its k-th access is more recent than frame 0's.
+  int value;
+  for (frame_id_t expected : {2, 4, 1, 0, 3}) {
+    ASSERT_TRUE(lru_replacer.Evict(&value));
+    ASSERT_EQ(expected, value);
+  }
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
 }  // namespace bustub
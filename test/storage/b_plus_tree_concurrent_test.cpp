@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -402,4 +403,234 @@ TEST(BPlusTreeConcurrentTest, MixTest2) {
   delete bpm;
 }
 
+// Small nodes, so that the writers keep switching between leaf-only changes and splits or merges.
+TEST(BPlusTreeConcurrentTest, MixTest3) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 4, 5);
+
+  std::vector<int64_t> perserved_keys;
+  std::vector<int64_t> dynamic_keys;
+  int64_t total_keys = 1000;
+  int64_t sieve = 3;
+  for (int64_t i = 1; i <= total_keys; i++) {
+    if (i % sieve == 0) {
+      perserved_keys.push_back(i);
+    } else {
+      dynamic_keys.push_back(i);
+    }
+  }
+  InsertHelper(&tree, perserved_keys, 1);
+
+  auto insert_task = [&](int tid) { InsertHelperSplit(&tree, dynamic_keys, 2, tid % 2); };
+  auto delete_task = [&](int tid) { DeleteHelperSplit(&tree, dynamic_keys, 2, tid % 2); };
+  auto lookup_task = [&](int tid) { LookupHelper(&tree, perserved_keys, tid); };
+
+  std::vector<std::thread> threads;
+  std::vector<std::function<void(int)>> tasks;
+  tasks.emplace_back(insert_task);
+  tasks.emplace_back(delete_task);
+  tasks.emplace_back(lookup_task);
+
+  size_t num_threads = 6;
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back(std::thread{tasks[i % tasks.size()], i});
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+
+  // All reserved keys are still there, in order, along with whatever dynamic keys survived.
+  size_t size = 0;
+  int64_t last_key = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    auto key = (*iter).first.ToString();
+    ASSERT_LT(last_key, key);
+    last_key = key;
+    if (key % sieve == 0) {
+      size++;
+    }
+  }
+  ASSERT_EQ(size, perserved_keys.size());
+  LookupHelper(&tree, perserved_keys, 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticReadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Small nodes make the writers split and merge internal pages under the readers all the time.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 3, 3);
+
+  std::vector<int64_t> perserved_keys;
+  std::vector<int64_t> dynamic_keys;
+  for (int64_t i = 1; i <= 2000; i++) {
+    (i % 4 == 0 ? perserved_keys : dynamic_keys).push_back(i);
+  }
+  InsertHelper(&tree, perserved_keys, 1);
+
+  std::atomic<bool> done{false};
+  auto write_task = [&](int tid) {
+    for (int round = 0; round < 3; round++) {
+      InsertHelperSplit(&tree, dynamic_keys, 2, tid % 2);
+      DeleteHelperSplit(&tree, dynamic_keys, 2, tid % 2);
+    }
+  };
+  auto read_task = [&](int tid) {
+    GenericKey<8> index_key;
+    while (!done) {
+      LookupHelper(&tree, perserved_keys, tid);
+      // An iterator positioned at a preserved key starts on the leaf that holds it.
+      for (size_t i = 0; i < perserved_keys.size(); i += 7) {
+        index_key.SetFromInteger(perserved_keys[i]);
+        auto iter = tree.Begin(index_key);
+        ASSERT_FALSE(iter.IsEnd());
+        ASSERT_EQ((*iter).first.ToString(), perserved_keys[i]);
+      }
+    }
+  };
+
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    writers.emplace_back(write_task, i);
+  }
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back(read_task, i);
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  LookupHelper(&tree, perserved_keys, 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, LazyDeleteTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 4, 5);
+  tree.StartBackgroundCompactor();
+
+  std::vector<int64_t> keys;
+  std::vector<int64_t> remove_keys;
+  std::vector<int64_t> perserved_keys;
+  for (int64_t i = 1; i <= 2000; i++) {
+    keys.push_back(i);
+    (i % 10 == 0 ? perserved_keys : remove_keys).push_back(i);
+  }
+  LaunchParallelTest(4, InsertHelperSplit, &tree, keys, 4);
+  // Removes leave underfull leaves behind for the compactor while lookups run alongside.
+  std::atomic<bool> done{false};
+  std::thread reader([&]() {
+    while (!done) {
+      LookupHelper(&tree, perserved_keys, 0);
+    }
+  });
+  LaunchParallelTest(4, DeleteHelperSplit, &tree, remove_keys, 4);
+  done = true;
+  reader.join();
+  tree.StopBackgroundCompactor();
+
+  // Stopping drains the queue, so no leaf is left underfull and the remaining keys fill at least half of each leaf.
+  auto stats = tree.Analyze();
+  ASSERT_EQ(stats.num_errors_, 0);
+  ASSERT_EQ(stats.underfull_pages_, 0);
+  ASSERT_LE(stats.pages_.back(), perserved_keys.size() / 2);
+
+  LookupHelper(&tree, perserved_keys, 0);
+  size_t size = 0;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    ASSERT_EQ((*iter).first.ToString(), perserved_keys[size]);
+    size++;
+  }
+  ASSERT_EQ(size, perserved_keys.size());
+
+  // Once stopped, removes merge eagerly again and can empty the tree.
+  DeleteHelper(&tree, perserved_keys);
+  ASSERT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, AnalyzeWhileModifiedTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 3, 5);
+
+  std::vector<int64_t> keys;
+  for (int64_t i = 1; i <= 2000; i++) {
+    keys.push_back(i);
+  }
+  // Walks that overlap the splits report no integrity errors, only that the tree was not quiescent.
+  std::atomic<bool> done{false};
+  std::thread analyzer([&]() {
+    while (!done) {
+      auto stats = tree.Analyze(2);
+      ASSERT_EQ(stats.num_errors_, 0);
+      ASSERT_TRUE(stats.errors_.empty());
+    }
+  });
+  LaunchParallelTest(4, InsertHelperSplit, &tree, keys, 4);
+  done = true;
+  analyzer.join();
+
+  auto stats = tree.Analyze(2);
+  ASSERT_TRUE(stats.is_quiescent_);
+  ASSERT_EQ(stats.num_errors_, 0);
+  ASSERT_EQ(stats.entries_.back(), keys.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
 }  // namespace bustub
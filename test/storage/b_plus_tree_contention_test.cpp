@@ -24,7 +24,7 @@ bool BPlusTreeLockBenchmarkCall(size_t num_threads, int leaf_node_size, bool wit
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
-  auto *disk_manager = new DiskManagerMemory(256 << 10);  // 1GB
+  auto *disk_manager = new DiskManagerMemory((1 << 30) / BUSTUB_PAGE_SIZE);  // 1GB
   auto *bpm = new BufferPoolManager(64, disk_manager);
 
   // create and fetch header_page
@@ -12,6 +12,11 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -184,4 +189,286 @@ TEST(BPlusTreeTests, InsertTest3) {
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  for (auto [leaf_max_size, internal_max_size, fill_factor] :
+       std::vector<std::tuple<int, int, double>>{{2, 3, 1.0}, {3, 3, 0.5}, {4, 5, 0.9}, {255, 255, 0.9}}) {
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, leaf_max_size,
+                                                             internal_max_size);
+
+    // Every third key shows up twice; the first entry for it is the one loaded.
+    std::vector<std::pair<GenericKey<8>, RID>> entries;
+    int64_t num_keys = 1000;
+    for (int64_t key = 1; key <= num_keys; key++) {
+      entries.emplace_back();
+      entries.back().first.SetFromInteger(key);
+      entries.back().second.Set(0, key);
+      if (key % 3 == 0) {
+        entries.push_back(entries.back());
+        entries.back().second.Set(1, key);
+      }
+    }
+    ASSERT_TRUE(tree.BulkLoad(entries.cbegin(), entries.cend(), fill_factor));
+    ASSERT_FALSE(tree.BulkLoad(entries.cbegin(), entries.cend(), fill_factor));
+
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+      ASSERT_EQ((*iterator).first.ToString(), current_key);
+      ASSERT_EQ((*iterator).second, RID(0, current_key));
+      current_key++;
+    }
+    ASSERT_EQ(current_key, num_keys + 1);
+
+    // The loaded tree splits and merges like one built by inserts.
+    GenericKey<8> index_key;
+    for (int64_t key = num_keys + 1; key <= 2 * num_keys; key++) {
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.Insert(index_key, RID(0, key)));
+    }
+    for (int64_t key = 1; key <= 2 * num_keys; key++) {
+      std::vector<RID> rids;
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.GetValue(index_key, &rids));
+      ASSERT_EQ(rids[0], RID(0, key));
+      tree.Remove(index_key, nullptr);
+    }
+    ASSERT_TRUE(tree.IsEmpty());
+    bpm->UnpinPage(page_id, true);
+  }
+
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, RangeScanTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 3, 4);
+
+  // Even keys only, so that bounds fall both on and between keys. Removing a run of keys leaves separators behind
+  // that no longer exist in any leaf, which reverse scans have to step over.
+  std::set<int64_t> keys;
+  GenericKey<8> index_key;
+  for (int64_t key = 2; key <= 200; key += 2) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, key)));
+    keys.insert(key);
+  }
+  for (int64_t key = 60; key <= 120; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, nullptr);
+    keys.erase(key);
+  }
+
+  auto check = [&](std::optional<int64_t> lower, bool lower_inclusive, std::optional<int64_t> upper,
+                   bool upper_inclusive, bool reverse) {
+    KeyRange<GenericKey<8>> range;
+    range.lower_inclusive_ = lower_inclusive;
+    range.upper_inclusive_ = upper_inclusive;
+    if (lower.has_value()) {
+      range.lower_.emplace();
+      range.lower_->SetFromInteger(*lower);
+    }
+    if (upper.has_value()) {
+      range.upper_.emplace();
+      range.upper_->SetFromInteger(*upper);
+    }
+    std::vector<int64_t> expected;
+    for (auto key : keys) {
+      if ((!lower.has_value() || key > *lower || (key == *lower && lower_inclusive)) &&
+          (!upper.has_value() || key < *upper || (key == *upper && upper_inclusive))) {
+        expected.push_back(key);
+      }
+    }
+    if (reverse) {
+      std::reverse(expected.begin(), expected.end());
+    }
+    std::vector<int64_t> scanned;
+    for (auto iterator = tree.Scan(range, reverse); !iterator.IsEnd(); ++iterator) {
+      scanned.push_back((*iterator).first.ToString());
+      ASSERT_EQ((*iterator).second, RID(0, scanned.back()));
+    }
+    ASSERT_EQ(scanned, expected);
+  };
+
+  std::vector<std::optional<int64_t>> bounds{std::nullopt, 0, 1, 2, 3, 57, 58, 59, 60, 90, 122, 123, 150, 200, 201};
+  for (const auto &lower : bounds) {
+    for (const auto &upper : bounds) {
+      for (int flags = 0; flags < 8; flags++) {
+        check(lower, (flags & 1) != 0, upper, (flags & 2) != 0, (flags & 4) != 0);
+      }
+    }
+  }
+
+  bpm->UnpinPage(page_id, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, NonUniqueTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_idx", page_id, bpm, comparator, 3, 4, false);
+
+  // Key k shows up k % 7 times, so duplicates spill over several leaves. RIDs go in out of order.
+  int64_t num_keys = 60;
+  GenericKey<16> index_key;
+  for (int dup = 6; dup >= 0; dup--) {
+    for (int64_t key = 0; key < num_keys; key++) {
+      if (dup < key % 7) {
+        index_key.SetFromInteger(key);
+        ASSERT_TRUE(tree.Insert(index_key, RID(dup, key)));
+        ASSERT_FALSE(tree.Insert(index_key, RID(dup, key)));
+      }
+    }
+  }
+
+  auto check = [&](int64_t key, const std::vector<int> &dups) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    ASSERT_EQ(tree.GetValue(index_key, &rids), !dups.empty());
+    ASSERT_EQ(rids.size(), dups.size()) << key;
+    for (size_t i = 0; i < dups.size(); i++) {
+      ASSERT_EQ(rids[i], RID(dups[i], key));
+    }
+  };
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::vector<int> dups;
+    for (int dup = 0; dup < key % 7; dup++) {
+      dups.push_back(dup);
+    }
+    check(key, dups);
+  }
+
+  // Removing one entry of a key leaves the others alone.
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, RID(1, key), nullptr);
+    tree.Remove(index_key, RID(7, key), nullptr);
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::vector<int> dups;
+    for (int dup = 0; dup < key % 7; dup++) {
+      if (dup != 1) {
+        dups.push_back(dup);
+      }
+    }
+    check(key, dups);
+  }
+
+  // A range scan returns every entry of its bounds, in key and then RID order.
+  KeyRange<GenericKey<16>> range;
+  range.lower_.emplace();
+  range.lower_->SetFromInteger(13);
+  range.lower_inclusive_ = false;
+  range.upper_.emplace();
+  range.upper_->SetFromInteger(20);
+  std::vector<std::pair<int64_t, RID>> expected;
+  for (int64_t key = 14; key <= 20; key++) {
+    for (int dup = 0; dup < key % 7; dup++) {
+      if (dup != 1) {
+        expected.emplace_back(key, RID(dup, key));
+      }
+    }
+  }
+  std::vector<std::pair<int64_t, RID>> scanned;
+  for (auto iterator = tree.Scan(range); !iterator.IsEnd(); ++iterator) {
+    scanned.emplace_back((*iterator).first.ToString(), (*iterator).second);
+  }
+  ASSERT_EQ(scanned, expected);
+
+  bpm->UnpinPage(page_id, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, AnalyzeTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 3, 4);
+  ASSERT_EQ(tree.Analyze().height_, 0);
+
+  int64_t num_keys = 500;
+  GenericKey<8> index_key;
+  for (int64_t key = num_keys; key > 0; key--) {
+    index_key.SetFromInteger(key * 3);
+    tree.Insert(index_key, RID(key));
+  }
+
+  auto stats = tree.Analyze(1, 10);
+  ASSERT_EQ(stats.num_errors_, 0) << stats.errors_[0];
+  ASSERT_GE(stats.height_, 5);
+  ASSERT_EQ(stats.pages_[0], 1);
+  ASSERT_EQ(stats.entries_.back(), num_keys);
+  ASSERT_EQ(stats.underfull_pages_, 0);
+  for (int level = 0; level + 1 < stats.height_; level++) {
+    // Every page of a level is a child of the level above it.
+    ASSERT_EQ(stats.entries_[level], stats.pages_[level + 1]);
+    ASSERT_GT(stats.FillFactor(level), 0.0);
+    ASSERT_LE(stats.FillFactor(level), 1.0);
+  }
+  ASSERT_LE(stats.histogram_.size(), 10);
+  ASSERT_GE(stats.histogram_.size(), 5);
+  ASSERT_EQ(stats.histogram_[0].first.ToString(), 3);
+  size_t histogram_keys = 0;
+  for (size_t i = 0; i < stats.histogram_.size(); i++) {
+    histogram_keys += stats.histogram_[i].second;
+    if (i > 0) {
+      ASSERT_LT(comparator(stats.histogram_[i - 1].first, stats.histogram_[i].first), 0);
+    }
+  }
+  ASSERT_EQ(histogram_keys, num_keys);
+
+  // Walking subtrees in parallel finds the same.
+  auto parallel_stats = tree.Analyze(4, 10);
+  ASSERT_EQ(parallel_stats.num_errors_, 0);
+  ASSERT_EQ(parallel_stats.pages_, stats.pages_);
+  ASSERT_EQ(parallel_stats.entries_, stats.entries_);
+  ASSERT_EQ(parallel_stats.leaf_chain_breaks_, stats.leaf_chain_breaks_);
+  ASSERT_EQ(parallel_stats.histogram_.size(), stats.histogram_.size());
+
+  // Cut the leaf chain after the leftmost leaf.
+  auto leaf_page_id = tree.GetRootPageId();
+  while (true) {
+    auto guard = bpm->FetchPageRead(leaf_page_id);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      break;
+    }
+    leaf_page_id = guard.As<BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>>()->ValueAt(0);
+  }
+  bpm->FetchPageWrite(leaf_page_id)
+      .AsMut<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>>()
+      ->SetNextPageId(INVALID_PAGE_ID);
+  auto broken_stats = tree.Analyze(4, 10);
+  ASSERT_EQ(broken_stats.num_errors_, 1);
+  ASSERT_NE(broken_stats.errors_[0].find(std::to_string(leaf_page_id)), std::string::npos);
+
+  bpm->UnpinPage(page_id, true);
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -11,10 +11,13 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_direct.h"
 
 namespace bustub {
 
@@ -55,6 +58,34 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Scenario: a page that starts past the 4 GiB mark. The file is sparse, so this only takes one page of disk.
+  const page_id_t far_page_id = (int64_t{1} << 32) / BUSTUB_PAGE_SIZE + 3;
+  auto dm = DiskManager(db_file);
+  dm.WritePage(far_page_id, data);
+  dm.WritePage(1, data);
+  dm.ReadPage(far_page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Reading past the end of the file yields a zeroed page.
+  dm.ReadPage(far_page_id + 1, buf);
+  EXPECT_EQ(buf[0], 0);
+  dm.ShutDown();
+
+  // Scenario: the cached file size is picked up again when the file is reopened.
+  auto reopened = DiskManager(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  reopened.ReadPage(far_page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  reopened.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -75,4 +106,75 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectReadWritePageTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  DiskManagerDirect dm(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.ReadPage(0, buf);  // tolerate empty read
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  std::memset(buf, 0, sizeof(buf));
+  dm.WritePage(5, data);
+  dm.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // The file can be reopened by the stream-based disk manager.
+  dm.ShutDown();
+  auto stream_dm = DiskManager(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  stream_dm.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  stream_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectConcurrentAndBatchedWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 16;
+  std::string db_file("test.db");
+  DiskManagerDirect dm(db_file);
+
+  // Scenario: threads write and read back disjoint pages concurrently.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid]() {
+      std::vector<char> data(BUSTUB_PAGE_SIZE);
+      std::vector<char> buf(BUSTUB_PAGE_SIZE);
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::fill(data.begin(), data.end(), static_cast<char>(page_id));
+        dm.WritePage(page_id, data.data());
+        dm.ReadPage(page_id, buf.data());
+        EXPECT_EQ(data, buf);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: a batch with runs of consecutive pages, in no particular order.
+  std::vector<std::vector<char>> pages;
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (page_id_t page_id : {7, 3, 4, 5, 20, 6, 21}) {
+    pages.emplace_back(BUSTUB_PAGE_SIZE, static_cast<char>(page_id + 100));
+    batch.emplace_back(page_id, pages.back().data());
+  }
+  dm.WritePages(batch);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < batch.size(); i++) {
+    dm.ReadPage(batch[i].first, buf.data());
+    EXPECT_EQ(pages[i], buf);
+  }
+  EXPECT_EQ(num_threads * pages_per_thread + batch.size(), dm.GetNumWrites());
+  dm.ShutDown();
+}
+
 }  // namespace bustub
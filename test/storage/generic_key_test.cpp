@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_page.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(GenericKeyTest, OrderTest) {
+  auto key_schema = ParseCreateStatement("a integer,b double,c varchar(16)");
+  GenericComparator<32> comparator(key_schema.get());
+
+  // Listed in ascending order.
+  std::vector<std::vector<Value>> rows{
+      {ValueFactory::GetIntegerValue(-7), ValueFactory::GetDecimalValue(1.5), ValueFactory::GetVarcharValue("z")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(-2.5), ValueFactory::GetVarcharValue("b")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(-0.5), ValueFactory::GetVarcharValue("b")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(3.0), ValueFactory::GetVarcharValue("")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(3.0), ValueFactory::GetVarcharValue("ab")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(3.0), ValueFactory::GetVarcharValue("abc")},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetDecimalValue(3.0), ValueFactory::GetVarcharValue("b")},
+      {ValueFactory::GetIntegerValue(300), ValueFactory::GetDecimalValue(0.0), ValueFactory::GetVarcharValue("a")},
+  };
+  std::vector<GenericKey<32>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], key_schema.get()), *key_schema);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      ASSERT_EQ(comparator(keys[i], keys[j]), i < j ? -1 : (i > j ? 1 : 0)) << i << " vs " << j;
+    }
+    for (uint32_t col = 0; col < key_schema->GetColumnCount(); col++) {
+      ASSERT_EQ(keys[i].ToValue(key_schema.get(), col).CompareEquals(rows[i][col]), CmpBool::CmpTrue);
+    }
+  }
+
+  // Integer keys built by the tests order like the integers themselves.
+  GenericComparator<8> int_comparator(nullptr);
+  GenericKey<8> lhs;
+  GenericKey<8> rhs;
+  std::vector<int64_t> ints{INT64_MIN + 1, -300, -1, 0, 1, 255, 256, INT64_MAX};
+  for (size_t i = 0; i + 1 < ints.size(); i++) {
+    lhs.SetFromInteger(ints[i]);
+    rhs.SetFromInteger(ints[i + 1]);
+    ASSERT_EQ(int_comparator(lhs, rhs), -1);
+    ASSERT_EQ(lhs.ToString(), ints[i]);
+  }
+}
+
+TEST(GenericKeyTest, KeyRankTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Sorted keys with duplicates and both extremes, ranked over every prefix so that all window sizes show up.
+  std::vector<int64_t> ints{INT64_MIN, INT64_MIN, -1000, -1};
+  for (int64_t i = 0; i < 100; i++) {
+    ints.push_back(i / 3 * 7);
+  }
+  ints.push_back(INT64_MAX);
+  std::vector<GenericKey<8>> keys(ints.size());
+  for (size_t i = 0; i < ints.size(); i++) {
+    keys[i].SetFromInteger(ints[i]);
+  }
+  std::vector<int64_t> probes{INT64_MIN, INT64_MAX, -1001, -1000, -999, 0, 1, 7, 8, 230, 231, 232, 1000};
+  GenericKey<8> probe;
+  for (int size = 0; size <= static_cast<int>(ints.size()); size++) {
+    for (auto value : probes) {
+      probe.SetFromInteger(value);
+      auto lower = std::lower_bound(ints.begin(), ints.begin() + size, value) - ints.begin();
+      auto upper = std::upper_bound(ints.begin(), ints.begin() + size, value) - ints.begin();
+      ASSERT_EQ(KeyRank(keys.data(), size, probe, comparator, false), lower) << size << " " << value;
+      ASSERT_EQ(KeyRank(keys.data(), size, probe, comparator, true), upper) << size << " " << value;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -11,16 +11,23 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/table_page.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -61,4 +68,524 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Check that table pages fill up to the capacity implied by the configured page size
+TEST(TupleTest, TablePageCapacityTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}}};
+  Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(42)}, &schema};
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(10, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  // Every tuple takes a 16-byte slot entry next to its data, after the page header.
+  const size_t tuples_per_page = (BUSTUB_PAGE_SIZE - TABLE_PAGE_HEADER_SIZE) / (16 + tuple.GetLength());
+  auto first_page_id = table->GetFirstPageId();
+  for (size_t i = 0; i < tuples_per_page; i++) {
+    auto rid = table->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+    ASSERT_TRUE(rid.has_value());
+    ASSERT_EQ(first_page_id, rid->GetPageId());
+    ASSERT_EQ(i, rid->GetSlotNum());
+  }
+  auto rid = table->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+  ASSERT_TRUE(rid.has_value());
+  EXPECT_NE(first_page_id, rid->GetPageId());
+  EXPECT_EQ(0, rid->GetSlotNum());
+}
+
+// NOLINTNEXTLINE
+// Check that the table iterator reads every page once and hands out its tuples in order
+TEST(TupleTest, TableIteratorTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}}};
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(10, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  std::vector<RID> rids;
+  std::vector<page_id_t> page_ids;
+  for (int64_t i = 0; i < 2000; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i)}, &schema};
+    auto rid = table->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+    ASSERT_TRUE(rid.has_value());
+    rids.push_back(*rid);
+    if (page_ids.empty() || page_ids.back() != rid->GetPageId()) {
+      page_ids.push_back(rid->GetPageId());
+    }
+  }
+  ASSERT_GT(page_ids.size(), 2);
+
+  auto scans = bpm->GetHitCount(AccessType::Scan) + bpm->GetMissCount(AccessType::Scan);
+  size_t count = 0;
+  for (auto iter = table->MakeIterator(); !iter.IsEnd(); ++iter) {
+    ASSERT_EQ(iter.GetRID(), rids[count]);
+    auto [meta, tuple] = iter.GetTuple();
+    ASSERT_EQ(tuple.GetRid(), rids[count]);
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int64_t>(), static_cast<int64_t>(count));
+    count++;
+  }
+  ASSERT_EQ(count, rids.size());
+  ASSERT_EQ(bpm->GetHitCount(AccessType::Scan) + bpm->GetMissCount(AccessType::Scan) - scans, page_ids.size());
+
+  // Batches are whole pages, except for the first one, which starts where the iterator stands.
+  auto iter = table->MakeIterator();
+  ++iter;
+  count = 1;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    auto batch = iter.NextBatch();
+    ASSERT_FALSE(batch.empty());
+    for (const auto &[meta, tuple] : batch) {
+      ASSERT_EQ(tuple.GetRid(), rids[count]);
+      ASSERT_EQ(tuple.GetRid().GetPageId(), page_ids[i]);
+      count++;
+    }
+  }
+  ASSERT_EQ(count, rids.size());
+  ASSERT_TRUE(iter.IsEnd());
+  ASSERT_TRUE(iter.NextBatch().empty());
+
+  // Tuples inserted during a scan are only seen by an eager iterator.
+  auto bounded_iter = table->MakeIterator();
+  auto eager_iter = table->MakeEagerIterator();
+  Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(-1)}, &schema};
+  auto last_rid = table->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+  count = 0;
+  for (; !bounded_iter.IsEnd(); ++bounded_iter) {
+    count++;
+  }
+  ASSERT_EQ(count, rids.size());
+  RID eager_last_rid;
+  count = 0;
+  for (; !eager_iter.IsEnd(); ++eager_iter) {
+    eager_last_rid = eager_iter.GetRID();
+    count++;
+  }
+  ASSERT_EQ(count, rids.size() + 1);
+  ASSERT_EQ(eager_last_rid, *last_rid);
+}
+
+// NOLINTNEXTLINE
+// Check that deleted tuples are vacuumed once they make up half of a page and that inserts reuse the space
+TEST(TupleTest, VacuumTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}}};
+  const TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  const TupleMeta deleted{INVALID_TXN_ID, INVALID_TXN_ID, true};
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(10, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  std::vector<RID> rids;
+  for (int64_t i = 0; i < 1000; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i)}, &schema};
+    rids.push_back(*table->InsertTuple(live, tuple));
+  }
+  auto first_page_id = table->GetFirstPageId();
+  ASSERT_NE(rids.back().GetPageId(), first_page_id);
+
+  Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(-1)}, &schema};
+
+  // Deleting every other tuple of the first page removes them from it once half of the page is deleted.
+  std::vector<RID> first_page_rids;
+  for (size_t i = 0; rids[i].GetPageId() == first_page_id; i++) {
+    first_page_rids.push_back(rids[i]);
+  }
+  for (size_t i = 0; i < first_page_rids.size(); i += 2) {
+    table->UpdateTupleMeta(deleted, first_page_rids[i]);
+  }
+  {
+    auto page_guard = bpm->FetchPageRead(first_page_id);
+    auto page = page_guard.As<TablePage>();
+    ASSERT_EQ(page->GetNumDeletedTuples(), 0);
+    // The slots of the deleted tuples stay, as the RIDs of the tuples after them must not change.
+    auto num_deleted = (first_page_rids.size() + 1) / 2;
+    ASSERT_EQ(page->GetFreeSpace(), BUSTUB_PAGE_SIZE - TABLE_PAGE_HEADER_SIZE -
+                                        first_page_rids.size() * TablePage::SpaceFor(tuple.GetLength()) +
+                                        num_deleted * tuple.GetLength());
+  }
+  // The tuples that are left are still where their RIDs say.
+  for (size_t i = 1; i < first_page_rids.size(); i += 2) {
+    auto [meta, left] = table->GetTuple(first_page_rids[i]);
+    ASSERT_FALSE(meta.is_deleted_);
+    ASSERT_EQ(left.GetValue(&schema, 0).GetAs<int64_t>(), static_cast<int64_t>(i));
+  }
+
+  // While a bounded scan is open, inserts go to a page appended after it began, so the scan does not see them.
+  {
+    auto iter = table->MakeIterator();
+    auto rid = table->InsertTuple(live, tuple);
+    ASSERT_EQ(bpm->FetchPageRead(rids.back().GetPageId()).As<TablePage>()->GetNextPageId(), rid->GetPageId());
+    size_t count = 0;
+    for (; !iter.IsEnd(); ++iter) {
+      count += iter.GetTuple().first.is_deleted_ ? 0 : 1;
+    }
+    ASSERT_EQ(count, rids.size() - (first_page_rids.size() + 1) / 2);
+  }
+  // Afterwards, they take free space in the pages the scan reached again: first the page that was left behind, which
+  // has the least, then the freed slots.
+  auto rid = table->InsertTuple(live, tuple);
+  ASSERT_EQ(rid->GetPageId(), rids.back().GetPageId());
+  while (rid->GetPageId() == rids.back().GetPageId()) {
+    rid = table->InsertTuple(live, tuple);
+  }
+  ASSERT_EQ(*rid, first_page_rids[0]);
+
+  // Vacuum() removes the deleted tuples that were too few to be removed on the way.
+  table->UpdateTupleMeta(deleted, rids.back());
+  auto stats = table->Vacuum();
+  ASSERT_EQ(stats.pages_vacuumed_, 1);
+  ASSERT_EQ(stats.tuples_removed_, 1);
+  size_t num_pages = 0;
+  size_t free_bytes = 0;
+  for (auto page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    auto page_guard = bpm->FetchPageRead(page_id);
+    auto page = page_guard.As<TablePage>();
+    ASSERT_EQ(page->GetNumDeletedTuples(), 0);
+    num_pages++;
+    free_bytes += page->GetFreeSpace();
+    page_id = page->GetNextPageId();
+  }
+  ASSERT_EQ(stats.pages_, num_pages);
+  ASSERT_EQ(stats.free_bytes_, free_bytes);
+}
+
+// NOLINTNEXTLINE
+// Check that updates happen in place while the tuple fits its page and move it to another page otherwise
+TEST(TupleTest, UpdateTupleTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 4000}}};
+  auto make_tuple = [&](int64_t a, size_t length) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(a), ValueFactory::GetVarcharValue(std::string(length, 'x'))};
+    return Tuple{values, &schema};
+  };
+  const TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(10, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  // Fill the first page, and put one tuple on the second.
+  std::vector<RID> rids;
+  std::vector<size_t> lengths;
+  while (rids.empty() || rids.back().GetPageId() == table->GetFirstPageId()) {
+    rids.push_back(*table->InsertTuple(live, make_tuple(rids.size(), 80)));
+    lengths.push_back(80);
+  }
+  auto update = [&](size_t i, size_t length) {
+    ASSERT_TRUE(table->UpdateTuple(live, make_tuple(i, length), rids[i]));
+    lengths[i] = length;
+  };
+  auto forward = [&](size_t i) {
+    auto page_guard = bpm->FetchPageRead(rids[i].GetPageId());
+    return page_guard.As<TablePage>()->GetForward(rids[i]);
+  };
+  // Every tuple is read and scanned once, under its own RID, with its latest value.
+  auto check = [&]() {
+    size_t count = 0;
+    for (auto iter = table->MakeIterator(); !iter.IsEnd(); ++iter) {
+      auto [meta, tuple] = iter.GetTuple();
+      if (meta.is_deleted_) {
+        continue;
+      }
+      auto i = tuple.GetValue(&schema, 0).GetAs<int64_t>();
+      ASSERT_EQ(iter.GetRID(), rids[i]);
+      ASSERT_EQ(tuple.GetValue(&schema, 1).ToString().size(), lengths[i]);
+      ASSERT_EQ(table->GetTuple(rids[i]).second.GetValue(&schema, 1).ToString().size(), lengths[i]);
+      count++;
+    }
+    ASSERT_EQ(count, std::count_if(lengths.begin(), lengths.end(), [](size_t length) { return length > 0; }));
+  };
+
+  // A tuple that shrinks leaves a hole, which the page reclaims when another one grows.
+  update(0, 10);
+  update(1, 150);
+  ASSERT_EQ(forward(1), std::nullopt);
+  check();
+
+  // A tuple that no longer fits into its page is moved, and comes back once it fits again.
+  update(2, 3000);
+  ASSERT_NE(forward(2), std::nullopt);
+  ASSERT_NE(forward(2)->GetPageId(), rids[2].GetPageId());
+  check();
+  update(2, 2000);
+  ASSERT_NE(forward(2), std::nullopt);
+  check();
+  update(2, 5);
+  ASSERT_EQ(forward(2), std::nullopt);
+  check();
+
+  // Deleting a moved tuple deletes it in both places.
+  update(3, 3000);
+  ASSERT_NE(forward(3), std::nullopt);
+  table->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[3]);
+  lengths[3] = 0;
+  check();
+  table->Vacuum();
+  check();
+}
+
+// NOLINTNEXTLINE
+// Check that readers see a whole tuple while it is moved between pages, back home, and its old copies are vacuumed
+TEST(TupleTest, ConcurrentMoveTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 4000}}};
+  auto make_tuple = [&](int64_t a, size_t length) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(a), ValueFactory::GetVarcharValue(std::string(length, 'x'))};
+    return Tuple{values, &schema};
+  };
+  const TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  const std::vector<size_t> lengths{3000, 2000, 3500, 5, 80};
+  const int num_readers = 4;
+  const int num_rounds = 500;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(20, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  // Fill the first page, so that the tuples that grow have to leave it.
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() == table->GetFirstPageId()) {
+    rids.push_back(*table->InsertTuple(live, make_tuple(rids.size(), 80)));
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < num_readers; t++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        for (size_t i = 0; i < 2; i++) {
+          auto [meta, tuple] = table->GetTuple(rids[i]);
+          ASSERT_FALSE(meta.is_deleted_);
+          ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int64_t>(), i);
+          auto length = tuple.GetValue(&schema, 1).ToString().size();
+          ASSERT_NE(std::find(lengths.begin(), lengths.end(), length), lengths.end());
+        }
+      }
+    });
+  }
+  for (int round = 0; round < num_rounds; round++) {
+    for (size_t i = 0; i < 2; i++) {
+      ASSERT_TRUE(table->UpdateTuple(live, make_tuple(i, lengths[(round + i) % lengths.size()]), rids[i]));
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that a PAX table stores tuples column by column and that scans read only the columns asked for
+TEST(TupleTest, PaxTableTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}, Column{"c", TypeId::BIGINT}}};
+  // Every third tuple has a null varchar, and every fifth a null bigint.
+  auto make_values = [](int32_t i) {
+    return std::vector<Value>{ValueFactory::GetIntegerValue(i),
+                              i % 3 == 0 ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                                         : ValueFactory::GetVarcharValue(std::string(i % 20, 'x')),
+                              i % 5 == 0 ? ValueFactory::GetNullValueByType(TypeId::BIGINT)
+                                         : ValueFactory::GetBigIntValue(i * 10L)};
+  };
+  auto check_value = [](const Value &expected, const Value &actual) {
+    ASSERT_EQ(expected.IsNull(), actual.IsNull());
+    if (!expected.IsNull()) {
+      ASSERT_EQ(expected.CompareEquals(actual), CmpBool::CmpTrue);
+    }
+  };
+  const TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(10, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get(), schema, TableStorage::Pax);
+  ASSERT_EQ(table->GetStorage(), TableStorage::Pax);
+
+  const int32_t num_tuples = 1000;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_tuples; i++) {
+    rids.push_back(*table->InsertTuple(live, Tuple{make_values(i), &schema}));
+  }
+  ASSERT_NE(rids.back().GetPageId(), table->GetFirstPageId());
+
+  // Tuples are put back together whole.
+  for (int32_t i = 0; i < num_tuples; i++) {
+    auto [meta, tuple] = table->GetTuple(rids[i]);
+    ASSERT_FALSE(meta.is_deleted_);
+    ASSERT_EQ(tuple.GetRid(), rids[i]);
+    auto values = make_values(i);
+    for (uint32_t column = 0; column < values.size(); column++) {
+      check_value(values[column], tuple.GetValue(&schema, column));
+    }
+  }
+
+  // PAX tuples are not updated in place, and their pages are not vacuumed.
+  ASSERT_FALSE(table->UpdateTuple(live, Tuple{make_values(0), &schema}, rids[0]));
+  table->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[1]);
+  ASSERT_TRUE(table->GetTupleMeta(rids[1]).is_deleted_);
+  auto stats = table->Vacuum();
+  ASSERT_EQ(stats.pages_, rids.back().GetPageId() - table->GetFirstPageId() + 1);
+  ASSERT_EQ(stats.tuples_removed_, 0);
+
+  // A scan of some of the columns reads only those, and leaves the others null.
+  int32_t i = 0;
+  for (auto iter = table->MakeIterator({2}); !iter.IsEnd(); ++iter, ++i) {
+    auto [meta, tuple] = iter.GetTuple();
+    ASSERT_EQ(iter.GetRID(), rids[i]);
+    ASSERT_EQ(meta.is_deleted_, i == 1);
+    ASSERT_TRUE(tuple.IsNull(&schema, 0));
+    ASSERT_TRUE(tuple.IsNull(&schema, 1));
+    check_value(make_values(i)[2], tuple.GetValue(&schema, 2));
+  }
+  ASSERT_EQ(i, num_tuples);
+
+  // A scan of all columns, or of the varchar alone, puts the values it reads back as they were inserted.
+  for (const auto &columns : std::vector<std::vector<uint32_t>>{{}, {1}}) {
+    i = 0;
+    for (auto iter = table->MakeIterator(columns); !iter.IsEnd(); ++iter, ++i) {
+      auto tuple = iter.GetTuple().second;
+      auto values = make_values(i);
+      for (uint32_t column = 0; column < values.size(); column++) {
+        if (columns.empty() || column == columns[0]) {
+          check_value(values[column], tuple.GetValue(&schema, column));
+        } else {
+          ASSERT_TRUE(tuple.IsNull(&schema, column));
+        }
+      }
+    }
+    ASSERT_EQ(i, num_tuples);
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that threads inserting at the same time each get a RID of their own
+TEST(TupleTest, ConcurrentInsertTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}}};
+  const int64_t num_threads = 8;
+  const int64_t tuples_per_thread = 1000;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int64_t i = 0; i < tuples_per_thread; i++) {
+        Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(t * tuples_per_thread + i)}, &schema};
+        rids[t].push_back(*table->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every tuple is found once, under the RID its insert returned.
+  std::vector<RID> found(num_threads * tuples_per_thread);
+  size_t count = 0;
+  for (auto iter = table->MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto value = iter.GetTuple().second.GetValue(&schema, 0).GetAs<int64_t>();
+    ASSERT_EQ(found[value], RID{});
+    found[value] = iter.GetRID();
+    count++;
+  }
+  ASSERT_EQ(count, found.size());
+  for (int64_t t = 0; t < num_threads; t++) {
+    for (int64_t i = 0; i < tuples_per_thread; i++) {
+      ASSERT_EQ(found[t * tuples_per_thread + i], rids[t][i]);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that inserts made while a scan is open stay out of its way without all going to one page
+TEST(TupleTest, InsertDuringScanTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}}};
+  const TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  const int64_t num_tuples = 1000;
+  const int64_t num_threads = 8;
+  const int64_t tuples_per_thread = 500;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto table = std::make_unique<TableHeap>(bpm.get());
+
+  std::unordered_set<page_id_t> scanned_pages;
+  for (int64_t i = 0; i < num_tuples; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i)}, &schema};
+    scanned_pages.insert(table->InsertTuple(live, tuple)->GetPageId());
+  }
+  // Freed slots in the pages the scan reaches are not reused either.
+  auto first_rid = RID{table->GetFirstPageId(), 0};
+  table->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, first_rid);
+  ASSERT_EQ(table->Vacuum().tuples_removed_, 1);
+
+  auto iter = std::make_unique<TableIterator>(table->MakeIterator());
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int64_t i = 0; i < tuples_per_thread; i++) {
+        Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(num_tuples + t * tuples_per_thread + i)}, &schema};
+        rids[t].push_back(*table->InsertTuple(live, tuple));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::unordered_set<page_id_t> first_pages;
+  for (const auto &thread_rids : rids) {
+    for (const auto &rid : thread_rids) {
+      ASSERT_EQ(scanned_pages.count(rid.GetPageId()), 0);
+    }
+    first_pages.insert(thread_rids[0].GetPageId());
+  }
+  // The threads started out on new pages of their own, rather than all appending to the last page.
+  ASSERT_GT(first_pages.size(), 1);
+
+  int64_t count = 0;
+  for (; !iter->IsEnd(); ++(*iter)) {
+    ASSERT_LT(iter->GetTuple().second.GetValue(&schema, 0).GetAs<int64_t>(), num_tuples);
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples - 1);
+
+  // Once the scan is closed, the free space it kept inserts out of is taken again.
+  iter.reset();
+  Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(-1)}, &schema};
+  ASSERT_EQ(scanned_pages.count(table->InsertTuple(live, tuple)->GetPageId()), 1);
+}
+
+// NOLINTNEXTLINE
+// Check that views share the bytes they point to and that tuples made from them own a copy
+TEST(TupleTest, TupleRefTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 16}}};
+
+  Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(42), ValueFactory::GetVarcharValue("bustub")}, &schema};
+  TupleRef view = tuple;
+  ASSERT_EQ(view.GetData(), tuple.GetData());
+  ASSERT_EQ(view.GetLength(), tuple.GetLength());
+  ASSERT_EQ(view.GetValue(&schema, 1).ToString(), "bustub");
+
+  Tuple copy{view};
+  ASSERT_NE(copy.GetData(), view.GetData());
+  ASSERT_EQ(copy.GetValue(&schema, 0).GetAs<int64_t>(), 42);
+
+  // A moved tuple keeps its bytes where they are, so views of it stay valid.
+  Tuple moved{std::move(tuple)};
+  ASSERT_EQ(moved.GetData(), view.GetData());
+  ASSERT_EQ(view.GetValue(&schema, 0).GetAs<int64_t>(), 42);
+
+  // Assigning a view copies into the buffer the tuple already has when it is large enough.
+  Tuple other{std::vector<Value>{ValueFactory::GetBigIntValue(7), ValueFactory::GetVarcharValue("bustub!!")}, &schema};
+  auto *buffer = other.GetData();
+  other = view;
+  ASSERT_EQ(other.GetData(), buffer);
+  ASSERT_EQ(other.GetLength(), view.GetLength());
+  ASSERT_EQ(other.GetValue(&schema, 1).ToString(), "bustub");
+
+  auto key_schema = Schema::CopySchema(&schema, {0});
+  auto key = view.KeyFromTuple(schema, key_schema, {0});
+  ASSERT_EQ(key.GetValue(&key_schema, 0).GetAs<int64_t>(), 42);
+}
+
 }  // namespace bustub
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <optional>
 #include <random>
 #include <sstream>
 #include <string>
@@ -53,15 +55,17 @@ struct BpmTotalMetrics {
     get_cnt_ += get_cnt;
   }
 
-  void Report() {
+  void Report(uint64_t get_hit_cnt, uint64_t get_miss_cnt) {
     auto now = ClockMs();
     auto elsped = now - start_time_;
     auto scan_per_sec = scan_cnt_ / static_cast<double>(elsped) * 1000;
     auto get_per_sec = get_cnt_ / static_cast<double>(elsped) * 1000;
+    auto get_hit_rate = get_hit_cnt / static_cast<double>(std::max<uint64_t>(get_hit_cnt + get_miss_cnt, 1));
 
     fmt::print("<<< BEGIN\n");
     fmt::print("scan: {}\n", scan_per_sec);
     fmt::print("get: {}\n", get_per_sec);
+    fmt::print("get_hit_rate: {}\n", get_hit_rate);
     fmt::print(">>> END\n");
   }
 };
@@ -105,11 +109,27 @@ auto main(int argc, char **argv) -> int {
   using bustub::AccessType;
   using bustub::BufferPoolManager;
   using bustub::DiskManagerUnlimitedMemory;
+  using bustub::FrameArenaOptions;
+  using bustub::NumaPolicy;
   using bustub::page_id_t;
 
   argparse::ArgumentParser program("bustub-bpm-bench");
   program.add_argument("--duration").help("run bpm bench for n milliseconds");
   program.add_argument("--latency").help("set disk latency to n milliseconds");
+  program.add_argument("--shards").help("partition the buffer pool into n shards");
+  program.add_argument("--no-scan-hint")
+      .help("fetch pages in scan threads with AccessType::Unknown instead of AccessType::Scan")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--page-cnt").help("create n pages (default 6400)");
+  program.add_argument("--bpm-size").help("size the buffer pool to n frames (default 64)");
+  program.add_argument("--uniform-gets")
+      .help("pick pages uniformly at random in get threads instead of from a zipfian distribution")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--arena")
+      .help("hold frames in a frame arena: 'plain', 'huge' (2 MiB huge pages) or 'none' (default)");
+  program.add_argument("--numa").help("NUMA placement of the frame arena: 'default', 'interleave' or 'bind-shards'");
 
   try {
     program.parse_args(argc, argv);
@@ -129,14 +149,51 @@ auto main(int argc, char **argv) -> int {
     latency_ms = std::stoi(program.get("--latency"));
   }
 
+  size_t shards = 1;
+  if (program.present("--shards")) {
+    shards = std::stoi(program.get("--shards"));
+  }
+
+  auto scan_access_type = program.get<bool>("--no-scan-hint") ? AccessType::Unknown : AccessType::Scan;
+
+  size_t page_cnt = BUSTUB_PAGE_CNT;
+  if (program.present("--page-cnt")) {
+    page_cnt = std::stoi(program.get("--page-cnt"));
+  }
+
+  size_t bpm_size = BUSTUB_BPM_SIZE;
+  if (program.present("--bpm-size")) {
+    bpm_size = std::stoi(program.get("--bpm-size"));
+  }
+
+  // With a pool large enough to hold every page and uniform gets, gets are hits spread over the whole pool, which
+  // makes the run bound by TLB misses rather than by the replacer. Compare --arena none, plain and huge on it.
+  bool uniform_gets = program.get<bool>("--uniform-gets");
+
+  std::optional<FrameArenaOptions> arena_options;
+  std::string arena = program.present("--arena") ? program.get("--arena") : "none";
+  std::string numa = program.present("--numa") ? program.get("--numa") : "default";
+  if (arena != "none" || numa != "default") {
+    arena_options = FrameArenaOptions{arena == "huge", NumaPolicy::Default};
+    if (numa == "interleave") {
+      arena_options->numa_policy_ = NumaPolicy::Interleave;
+    } else if (numa == "bind-shards") {
+      arena_options->numa_policy_ = NumaPolicy::BindShards;
+    }
+  }
+
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  auto bpm = std::make_unique<BufferPoolManager>(bpm_size, disk_manager.get(), LRU_K_SIZE, nullptr, shards,
+                                                 arena_options);
   std::vector<page_id_t> page_ids;
 
-  fmt::print(stderr, "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}\n",
-             BUSTUB_PAGE_CNT, duration_ms, latency_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] page_size={}, total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}, "
+             "shards={}, scan_hint={}, uniform_gets={}, arena={}, numa={}\n",
+             bustub::BUSTUB_PAGE_SIZE, page_cnt, duration_ms, latency_ms, LRU_K_SIZE, bpm_size, shards,
+             scan_access_type == AccessType::Scan, uniform_gets, arena, numa);
 
-  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
+  for (size_t i = 0; i < page_cnt; i++) {
     page_id_t page_id;
     auto *page = bpm->NewPage(&page_id);
     if (page == nullptr) {
@@ -160,14 +217,15 @@ auto main(int argc, char **argv) -> int {
   std::vector<std::thread> threads;
 
   for (size_t thread_id = 0; thread_id < BUSTUB_SCAN_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, scan_access_type, page_cnt,
+                                      &total_metrics] {
       BpmMetrics metrics(fmt::format("scan {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
-      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / BUSTUB_SCAN_THREAD;
+      size_t page_idx = page_cnt * thread_id / BUSTUB_SCAN_THREAD;
 
       while (!metrics.ShouldFinish()) {
-        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Scan);
+        auto *page = bpm->FetchPage(page_ids[page_idx], scan_access_type);
         if (page == nullptr) {
           continue;
         }
@@ -180,8 +238,8 @@ auto main(int argc, char **argv) -> int {
         }
         page->WUnlatch();
 
-        bpm->UnpinPage(page->GetPageId(), true, AccessType::Scan);
-        page_idx = (page_idx + 1) % BUSTUB_PAGE_CNT;
+        bpm->UnpinPage(page->GetPageId(), true, scan_access_type);
+        page_idx = (page_idx + 1) % page_cnt;
         metrics.Tick();
         metrics.Report();
       }
@@ -191,16 +249,18 @@ auto main(int argc, char **argv) -> int {
   }
 
   for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, page_cnt, uniform_gets,
+                                      &total_metrics] {
       std::random_device r;
       std::default_random_engine gen(r());
-      zipfian_int_distribution<size_t> dist(0, BUSTUB_PAGE_CNT - 1, 0.8);
+      zipfian_int_distribution<size_t> zipfian_dist(0, page_cnt - 1, 0.8);
+      std::uniform_int_distribution<size_t> uniform_dist(0, page_cnt - 1);
 
       BpmMetrics metrics(fmt::format("get  {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
       while (!metrics.ShouldFinish()) {
-        auto page_idx = dist(gen);
+        auto page_idx = uniform_gets ? uniform_dist(gen) : zipfian_dist(gen);
         auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
         if (page == nullptr) {
           continue;
@@ -226,7 +286,7 @@ auto main(int argc, char **argv) -> int {
     thread.join();
   }
 
-  total_metrics.Report();
+  total_metrics.Report(bpm->GetHitCount(AccessType::Get), bpm->GetMissCount(AccessType::Get));
 
   return 0;
 }
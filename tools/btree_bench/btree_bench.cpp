@@ -1,11 +1,16 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <optional>
 #include <random>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <cpp_random_distributions/zipfian_int_distribution.h>
@@ -32,42 +37,130 @@ auto ClockMs() -> uint64_t {
   return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
 }
 
-static const size_t BUSTUB_READ_THREAD = 4;
-static const size_t BUSTUB_WRITE_THREAD = 2;
-static const size_t LRU_K_SIZE = 4;
-static const size_t BUSTUB_BPM_SIZE = 256;
-static const size_t TOTAL_KEYS = 100000;
-static const size_t KEY_MODIFY_RANGE = 2048;
+auto ClockNs() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+using BenchKey = bustub::GenericKey<8>;
+using BenchTree = bustub::BPlusTree<BenchKey, bustub::RID, bustub::GenericComparator<8>>;
+
+enum class OpType { Read = 0, Insert, Delete, Scan };
+static constexpr size_t NUM_OP_TYPES = 4;
+static constexpr std::array<const char *, NUM_OP_TYPES> OP_NAMES = {"read", "insert", "delete", "scan"};
+
+struct BenchOptions {
+  uint64_t duration_ms_{30000};
+  std::vector<size_t> threads_{6};
+  size_t total_keys_{100000};
+  // The pool is given in 4 KiB units, so that builds with larger pages cache the same number of bytes.
+  size_t bpm_size_{256 * 4096 / bustub::BUSTUB_PAGE_SIZE};
+  size_t lru_k_size_{4};
+  size_t shards_{1};
+  bool zipfian_{false};
+  double zipfian_theta_{0.8};
+  // Relative weights of reads, inserts, deletes and range scans.
+  std::array<size_t, NUM_OP_TYPES> mix_{70, 15, 10, 5};
+  size_t scan_length_{100};
+  // Percentage of the key space loaded before the run starts.
+  size_t preload_pct_{50};
+  bool validate_{false};
+  bool json_{false};
+};
+
+/**
+ * Latency histogram with buckets that are exact below 16 ns and then 16 per power of two, so that a percentile is
+ * within about 6% of the true value.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t SUB_BUCKETS = 16;
+  static constexpr size_t NUM_BUCKETS = SUB_BUCKETS * 61;
+
+  void Record(uint64_t latency_ns) {
+    buckets_[BucketOf(latency_ns)]++;
+    count_++;
+    max_ns_ = std::max(max_ns_, latency_ns);
+  }
+
+  void Merge(const LatencyHistogram &that) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      buckets_[i] += that.buckets_[i];
+    }
+    count_ += that.count_;
+    max_ns_ = std::max(max_ns_, that.max_ns_);
+  }
+
+  auto Count() const -> uint64_t { return count_; }
+
+  auto Max() const -> uint64_t { return max_ns_; }
+
+  /** @return the lower bound of the bucket holding the given quantile, 0 if nothing was recorded */
+  auto Percentile(double quantile) const -> uint64_t {
+    if (count_ == 0) {
+      return 0;
+    }
+    auto rank = static_cast<uint64_t>(quantile * (count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return LowerBoundOf(i);
+      }
+    }
+    return max_ns_;
+  }
+
+ private:
+  static auto BucketOf(uint64_t value) -> size_t {
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+    auto exp = 63 - __builtin_clzll(value);
+    auto sub = (value >> (exp - 4)) & (SUB_BUCKETS - 1);
+    return std::min<size_t>((exp - 3) * SUB_BUCKETS + sub, NUM_BUCKETS - 1);
+  }
+
+  static auto LowerBoundOf(size_t bucket) -> uint64_t {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+    auto exp = bucket / SUB_BUCKETS + 3;
+    auto sub = bucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << (exp - 4);
+  }
+
+  std::vector<uint64_t> buckets_ = std::vector<uint64_t>(NUM_BUCKETS, 0);
+  uint64_t count_{0};
+  uint64_t max_ns_{0};
+};
 
 struct BTreeTotalMetrics {
-  uint64_t write_cnt_{0};
-  uint64_t read_cnt_{0};
+  std::array<LatencyHistogram, NUM_OP_TYPES> latency_;
   uint64_t start_time_{0};
+  uint64_t elapsed_ms_{0};
   std::mutex mutex_;
 
   void Begin() { start_time_ = ClockMs(); }
 
-  void ReportWrite(uint64_t scan_cnt) {
-    std::unique_lock<std::mutex> l(mutex_);
-    write_cnt_ += scan_cnt;
-  }
+  void End() { elapsed_ms_ = std::max<uint64_t>(ClockMs() - start_time_, 1); }
 
-  void ReportRead(uint64_t get_cnt) {
+  void ReportThread(const std::array<LatencyHistogram, NUM_OP_TYPES> &latency) {
     std::unique_lock<std::mutex> l(mutex_);
-    read_cnt_ += get_cnt;
+    for (size_t op = 0; op < NUM_OP_TYPES; op++) {
+      latency_[op].Merge(latency[op]);
+    }
   }
 
-  void Report() {
-    auto now = ClockMs();
-    auto elsped = now - start_time_;
-    auto write_per_sec = write_cnt_ / static_cast<double>(elsped) * 1000;
-    auto read_per_sec = read_cnt_ / static_cast<double>(elsped) * 1000;
-
-    fmt::print("<<< BEGIN\n");
-    fmt::print("write: {}\n", write_per_sec);
-    fmt::print("read: {}\n", read_per_sec);
-    fmt::print(">>> END\n");
+  auto TotalOps() const -> uint64_t {
+    uint64_t total = 0;
+    for (const auto &histogram : latency_) {
+      total += histogram.Count();
+    }
+    return total;
   }
+
+  auto OpsPerSec(uint64_t cnt) const -> double { return cnt / static_cast<double>(elapsed_ms_) * 1000; }
 };
 
 struct BTreeMetrics {
@@ -104,164 +197,402 @@ struct BTreeMetrics {
   }
 };
 
-// These keys will be deleted and inserted again
-auto KeyWillVanish(size_t key) -> bool { return key % 7 == 0; }
-
-// These keys will be overwritten to a new value
-auto KeyWillChange(size_t key) -> bool { return key % 5 == 0; }
+/** The result of one run of the sweep. */
+struct RunResult {
+  size_t threads_;
+  double elapsed_s_;
+  double ops_per_sec_;
+  std::array<double, NUM_OP_TYPES> op_per_sec_;
+  std::array<LatencyHistogram, NUM_OP_TYPES> latency_;
+  std::array<uint64_t, bustub::NUM_ACCESS_TYPES> hits_;
+  std::array<uint64_t, bustub::NUM_ACCESS_TYPES> misses_;
+  size_t final_keys_;
+  size_t validation_errors_;
+};
 
-// NOLINTNEXTLINE
-auto main(int argc, char **argv) -> int {
-  using bustub::AccessType;
-  using bustub::BufferPoolManager;
-  using bustub::DiskManagerUnlimitedMemory;
-  using bustub::page_id_t;
+// Keys are stored with a value derived from them, so that any lookup can be checked.
+auto ValueOf(size_t key) -> bustub::RID { return bustub::RID(static_cast<bustub::page_id_t>(key), key); }
 
-  argparse::ArgumentParser program("bustub-btree-bench");
-  program.add_argument("--duration").help("run btree bench for n milliseconds");
+// Spread the preloaded keys over the key space instead of loading a prefix of it.
+auto KeyIsPreloaded(size_t key, size_t preload_pct) -> bool { return (key * 2654435761ULL) % 100 < preload_pct; }
 
-  try {
-    program.parse_args(argc, argv);
-  } catch (const std::runtime_error &err) {
-    std::cerr << err.what() << std::endl;
-    std::cerr << program;
-    return 1;
+// Check a lookup against the reference. Returns false, after printing why, if the tree disagrees with it.
+auto CheckLookup(size_t key, bool expected, const std::vector<bustub::RID> &rids) -> bool {
+  if (!expected && !rids.empty()) {
+    fmt::print(stderr, "[error] deleted key found: {}\n", key);
+    return false;
   }
-
-  uint64_t duration_ms = 30000;
-  if (program.present("--duration")) {
-    duration_ms = std::stoi(program.get("--duration"));
+  if (expected && rids.size() != 1) {
+    fmt::print(stderr, "[error] key not found: {}\n", key);
+    return false;
   }
+  if (expected && !(rids[0] == ValueOf(key))) {
+    fmt::print(stderr, "[error] invalid data: {} -> {}\n", key, rids[0].Get());
+    return false;
+  }
+  return true;
+}
 
-  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
-
-  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS, duration_ms,
-             LRU_K_SIZE, BUSTUB_BPM_SIZE);
+auto RunBench(const BenchOptions &options, size_t num_threads) -> RunResult {
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManager>(options.bpm_size_, disk_manager.get(), options.lru_k_size_,
+                                                         nullptr, options.shards_);
 
   auto key_schema = bustub::ParseCreateStatement("a bigint");
   bustub::GenericComparator<8> comparator(key_schema.get());
 
-  page_id_t page_id;
+  bustub::page_id_t page_id;
   auto header_page = bpm->NewPageGuarded(&page_id);
+  BenchTree index("foo_pk", page_id, bpm.get(), comparator);
+
+  // The reference: whether each key is in the tree. In validation mode, each thread only modifies the keys k with
+  // k % num_threads == thread_id, so it is the only writer of its entries and can check every lookup of them.
+  std::vector<bool> present(options.total_keys_);
+  std::vector<std::pair<BenchKey, bustub::RID>> preload;
+  for (size_t key = 0; key < options.total_keys_; key++) {
+    if (KeyIsPreloaded(key, options.preload_pct_)) {
+      BenchKey index_key;
+      index_key.SetFromInteger(key);
+      preload.emplace_back(index_key, ValueOf(key));
+      present[key] = true;
+    }
+  }
+  index.BulkLoad(preload.begin(), preload.end());
+  preload.clear();
+
+  std::array<uint64_t, bustub::NUM_ACCESS_TYPES> hits_before;
+  std::array<uint64_t, bustub::NUM_ACCESS_TYPES> misses_before;
+  for (size_t type = 0; type < bustub::NUM_ACCESS_TYPES; type++) {
+    hits_before[type] = bpm->GetHitCount(static_cast<bustub::AccessType>(type));
+    misses_before[type] = bpm->GetMissCount(static_cast<bustub::AccessType>(type));
+  }
 
-  bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>> index("foo_pk", page_id,
-                                                                                            bpm.get(), comparator);
-
-  for (size_t key = 0; key < TOTAL_KEYS; key++) {
-    bustub::GenericKey<8> index_key;
-    bustub::RID rid;
-    uint32_t value = key;
-    rid.Set(value, value);
-    index_key.SetFromInteger(key);
-    index.Insert(index_key, rid, nullptr);
+  // Building the zipfian distribution sums over the whole key space, so it is done once and copied to the threads.
+  std::optional<zipfian_int_distribution<size_t>> zipfian;
+  if (options.zipfian_) {
+    zipfian.emplace(0, options.total_keys_ - 1, options.zipfian_theta_);
   }
 
-  fmt::print(stderr, "[info] benchmark start\n");
+  fmt::print(stderr, "[info] benchmark start, threads={}\n", num_threads);
 
   BTreeTotalMetrics total_metrics;
-  total_metrics.Begin();
-
+  std::vector<size_t> thread_errors(num_threads, 0);
+  std::vector<std::vector<bool>> thread_present(num_threads);
   std::vector<std::thread> threads;
+  total_metrics.Begin();
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_READ_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
-      BTreeMetrics metrics(fmt::format("read  {:>2}", thread_id), duration_ms);
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, num_threads, &index, &options, &present, zipfian, &total_metrics,
+                                      &thread_errors, &thread_present]() mutable {
+      BTreeMetrics metrics(fmt::format("worker {:>2}", thread_id), options.duration_ms_);
+      std::array<LatencyHistogram, NUM_OP_TYPES> latency;
+      // Each thread keeps its own copy of the reference, of which it only ever changes the keys it owns.
+      auto my_present = present;
       metrics.Begin();
 
-      size_t key_start = TOTAL_KEYS / BUSTUB_READ_THREAD * thread_id;
-      size_t key_end = TOTAL_KEYS / BUSTUB_READ_THREAD * (thread_id + 1);
       std::random_device r;
       std::default_random_engine gen(r());
-      std::uniform_int_distribution<size_t> dis(key_start, key_end - 1);
+      std::uniform_int_distribution<size_t> uniform(0, options.total_keys_ - 1);
+      std::discrete_distribution<size_t> op_dis(options.mix_.begin(), options.mix_.end());
 
-      bustub::GenericKey<8> index_key;
+      BenchKey index_key;
+      BenchKey upper_key;
       std::vector<bustub::RID> rids;
 
       while (!metrics.ShouldFinish()) {
-        auto base_key = dis(gen);
-        size_t cnt = 0;
-        for (auto key = base_key; key < key_end && cnt < KEY_MODIFY_RANGE; key++, cnt++) {
-          rids.clear();
-          index_key.SetFromInteger(key);
-          index.GetValue(index_key, &rids);
-
-          if (!KeyWillVanish(key) && rids.empty()) {
-            std::string msg = fmt::format("key not found: {}", key);
-            throw std::runtime_error(msg);
+        auto key = zipfian.has_value() ? (*zipfian)(gen) : uniform(gen);
+        auto op = static_cast<OpType>(op_dis(gen));
+        bool owned = key % num_threads == thread_id;
+        if (options.validate_ && !owned && op != OpType::Read && op != OpType::Scan) {
+          // Move the key to the nearest one this thread owns, so it stays the only writer of its keys.
+          key = key - key % num_threads + thread_id;
+          if (key >= options.total_keys_) {
+            continue;
           }
-
-          if (!KeyWillVanish(key) && !KeyWillChange(key)) {
-            if (rids.size() != 1) {
-              std::string msg = fmt::format("key not found: {}", key);
-              throw std::runtime_error(msg);
+          owned = true;
+        }
+        index_key.SetFromInteger(key);
+
+        auto start = ClockNs();
+        switch (op) {
+          case OpType::Read:
+            rids.clear();
+            index.GetValue(index_key, &rids);
+            break;
+          case OpType::Insert:
+            index.Insert(index_key, ValueOf(key), nullptr);
+            break;
+          case OpType::Delete:
+            index.Remove(index_key, nullptr);
+            break;
+          case OpType::Scan: {
+            upper_key.SetFromInteger(key + options.scan_length_ - 1);
+            size_t cnt = 0;
+            int64_t last = -1;
+            for (auto iter = index.Scan({index_key, true, upper_key, true}); !iter.IsEnd(); ++iter) {
+              auto scanned = static_cast<int64_t>((*iter).second.GetSlotNum());
+              if (options.validate_ && scanned <= last) {
+                fmt::print(stderr, "[error] scan out of order: {} after {}\n", scanned, last);
+                thread_errors[thread_id]++;
+              }
+              last = scanned;
+              cnt++;
             }
-            if (static_cast<size_t>(rids[0].GetPageId()) != key || static_cast<size_t>(rids[0].GetSlotNum()) != key) {
-              std::string msg = fmt::format("invalid data: {} -> {}", key, rids[0].Get());
-              throw std::runtime_error(msg);
+            if (options.validate_ && cnt > options.scan_length_) {
+              fmt::print(stderr, "[error] scan from {} returned {} keys\n", key, cnt);
+              thread_errors[thread_id]++;
             }
+            break;
           }
-          metrics.Tick();
-          metrics.Report();
         }
+        latency[static_cast<size_t>(op)].Record(ClockNs() - start);
+
+        if (op == OpType::Insert || op == OpType::Delete) {
+          my_present[key] = op == OpType::Insert;
+        } else if (options.validate_ && op == OpType::Read && (owned || !rids.empty()) &&
+                   !CheckLookup(key, owned ? my_present[key] : true, rids)) {
+          // Keys owned by other threads may come and go, but must hold the right value when found.
+          thread_errors[thread_id]++;
+        }
+        metrics.Tick();
+        metrics.Report();
       }
 
-      total_metrics.ReportRead(metrics.cnt_);
+      total_metrics.ReportThread(latency);
+      thread_present[thread_id] = std::move(my_present);
     }));
   }
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_WRITE_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
-      BTreeMetrics metrics(fmt::format("write {:>2}", thread_id), duration_ms);
-      metrics.Begin();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  total_metrics.End();
+
+  RunResult result;
+  result.threads_ = num_threads;
+  result.elapsed_s_ = total_metrics.elapsed_ms_ / 1000.0;
+  result.ops_per_sec_ = total_metrics.OpsPerSec(total_metrics.TotalOps());
+  for (size_t op = 0; op < NUM_OP_TYPES; op++) {
+    result.op_per_sec_[op] = total_metrics.OpsPerSec(total_metrics.latency_[op].Count());
+    result.latency_[op] = total_metrics.latency_[op];
+  }
+  for (size_t type = 0; type < bustub::NUM_ACCESS_TYPES; type++) {
+    result.hits_[type] = bpm->GetHitCount(static_cast<bustub::AccessType>(type)) - hits_before[type];
+    result.misses_[type] = bpm->GetMissCount(static_cast<bustub::AccessType>(type)) - misses_before[type];
+  }
+  result.validation_errors_ = 0;
+  for (auto errors : thread_errors) {
+    result.validation_errors_ += errors;
+  }
 
-      size_t key_start = TOTAL_KEYS / BUSTUB_WRITE_THREAD * thread_id;
-      size_t key_end = TOTAL_KEYS / BUSTUB_WRITE_THREAD * (thread_id + 1);
-      std::random_device r;
-      std::default_random_engine gen(r());
-      std::uniform_int_distribution<size_t> dis(key_start, key_end - 1);
+  // Count what is left in the tree and, when validating, compare it with the reference of the key's owner.
+  result.final_keys_ = 0;
+  size_t next_key = 0;
+  for (auto iter = index.Begin(); !iter.IsEnd(); ++iter) {
+    auto key = static_cast<size_t>((*iter).first.ToString());
+    result.final_keys_++;
+    if (!options.validate_) {
+      continue;
+    }
+    for (; next_key < key && next_key < options.total_keys_; next_key++) {
+      if (thread_present[next_key % num_threads][next_key]) {
+        fmt::print(stderr, "[error] key missing after run: {}\n", next_key);
+        result.validation_errors_++;
+      }
+    }
+    if (key >= options.total_keys_ || !thread_present[key % num_threads][key] ||
+        !((*iter).second == ValueOf(key))) {
+      fmt::print(stderr, "[error] unexpected entry after run: {} -> {}\n", key, (*iter).second.Get());
+      result.validation_errors_++;
+    }
+    next_key = key + 1;
+  }
+  if (options.validate_) {
+    for (; next_key < options.total_keys_; next_key++) {
+      if (thread_present[next_key % num_threads][next_key]) {
+        fmt::print(stderr, "[error] key missing after run: {}\n", next_key);
+        result.validation_errors_++;
+      }
+    }
+    auto stats = index.Analyze();
+    for (const auto &error : stats.errors_) {
+      fmt::print(stderr, "[error] {}\n", error);
+    }
+    result.validation_errors_ += stats.num_errors_;
+  }
 
-      bustub::GenericKey<8> index_key;
-      bustub::RID rid;
+  return result;
+}
 
-      bool do_insert = false;
+void PrintText(const BenchOptions &options, const std::vector<RunResult> &results) {
+  for (const auto &result : results) {
+    fmt::print("<<< BEGIN\n");
+    fmt::print("threads: {}\n", result.threads_);
+    fmt::print("total: {}\n", result.ops_per_sec_);
+    for (size_t op = 0; op < NUM_OP_TYPES; op++) {
+      const auto &latency = result.latency_[op];
+      fmt::print("{}: {} p50={}ns p99={}ns p999={}ns max={}ns\n", OP_NAMES[op], result.op_per_sec_[op],
+                 latency.Percentile(0.5), latency.Percentile(0.99), latency.Percentile(0.999), latency.Max());
+    }
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    for (size_t type = 0; type < bustub::NUM_ACCESS_TYPES; type++) {
+      hits += result.hits_[type];
+      misses += result.misses_[type];
+    }
+    fmt::print("bpm_hit: {}\n", hits);
+    fmt::print("bpm_miss: {}\n", misses);
+    fmt::print("bpm_hit_rate: {}\n", hits / static_cast<double>(std::max<uint64_t>(hits + misses, 1)));
+    fmt::print("final_keys: {}\n", result.final_keys_);
+    if (options.validate_) {
+      fmt::print("validation_errors: {}\n", result.validation_errors_);
+    }
+    fmt::print(">>> END\n");
+  }
+}
 
-      while (!metrics.ShouldFinish()) {
-        auto base_key = dis(gen);
-        size_t cnt = 0;
-        for (auto key = base_key; key < key_end && cnt < KEY_MODIFY_RANGE; key++, cnt++) {
-          if (KeyWillVanish(key)) {
-            uint32_t value = key;
-            rid.Set(value, value);
-            index_key.SetFromInteger(key);
-            if (do_insert) {
-              index.Insert(index_key, rid, nullptr);
-            } else {
-              index.Remove(index_key, nullptr);
-            }
-            metrics.Tick();
-            metrics.Report();
-          } else if (KeyWillChange(key)) {
-            uint32_t value = key;
-            rid.Set(value, dis(gen));
-            index_key.SetFromInteger(key);
-            index.Insert(index_key, rid, nullptr);
-            metrics.Tick();
-            metrics.Report();
-          }
-        }
-        do_insert = !do_insert;
+void PrintJson(const BenchOptions &options, const std::vector<RunResult> &results) {
+  static constexpr std::array<const char *, bustub::NUM_ACCESS_TYPES> ACCESS_TYPE_NAMES = {"unknown", "get", "scan"};
+  std::stringstream out;
+  out << fmt::format(
+      R"({{"config":{{"page_size":{},"total_keys":{},"duration_ms":{},"bpm_size":{},"lru_k_size":{},"shards":{},)",
+      bustub::BUSTUB_PAGE_SIZE, options.total_keys_, options.duration_ms_, options.bpm_size_, options.lru_k_size_,
+      options.shards_);
+  out << fmt::format(R"("distribution":"{}","zipfian_theta":{},"mix":{{"read":{},"insert":{},"delete":{},"scan":{}}},)",
+                     options.zipfian_ ? "zipfian" : "uniform", options.zipfian_theta_, options.mix_[0],
+                     options.mix_[1], options.mix_[2], options.mix_[3]);
+  out << fmt::format(R"("scan_length":{},"preload_pct":{},"validate":{}}},"runs":[)", options.scan_length_,
+                     options.preload_pct_, options.validate_);
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &result = results[i];
+    out << (i == 0 ? "" : ",");
+    out << fmt::format(R"({{"threads":{},"elapsed_s":{},"ops_per_sec":{},"ops":{{)", result.threads_,
+                       result.elapsed_s_, result.ops_per_sec_);
+    for (size_t op = 0; op < NUM_OP_TYPES; op++) {
+      const auto &latency = result.latency_[op];
+      out << fmt::format(
+          R"({}"{}":{{"count":{},"ops_per_sec":{},"p50_ns":{},"p99_ns":{},"p999_ns":{},"max_ns":{}}})",
+          op == 0 ? "" : ",", OP_NAMES[op], latency.Count(), result.op_per_sec_[op], latency.Percentile(0.5),
+          latency.Percentile(0.99), latency.Percentile(0.999), latency.Max());
+    }
+    out << R"(},"bpm":{)";
+    for (size_t type = 0; type < bustub::NUM_ACCESS_TYPES; type++) {
+      out << fmt::format(R"({}"{}":{{"hit":{},"miss":{}}})", type == 0 ? "" : ",", ACCESS_TYPE_NAMES[type],
+                         result.hits_[type], result.misses_[type]);
+    }
+    out << fmt::format(R"(}},"final_keys":{},"validation_errors":{}}})", result.final_keys_,
+                       result.validation_errors_);
+  }
+  out << "]}\n";
+  fmt::print("{}", out.str());
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-btree-bench");
+  program.add_argument("--duration").help("run each benchmark for n milliseconds");
+  program.add_argument("--shards").help("partition the buffer pool into n shards");
+  program.add_argument("--threads").help("comma-separated thread counts to sweep, e.g. 1,2,4,8");
+  program.add_argument("--keys").help("size of the key space");
+  program.add_argument("--bpm-size").help("number of frames in the buffer pool");
+  program.add_argument("--lru-k").help("k of the LRU-K replacer");
+  program.add_argument("--distribution").help("key distribution: uniform or zipfian");
+  program.add_argument("--zipfian-theta").help("skew of the zipfian distribution");
+  program.add_argument("--mix").help("weights of read:insert:delete:scan operations, e.g. 70:15:10:5");
+  program.add_argument("--scan-length").help("width of the key range of a range scan");
+  program.add_argument("--preload").help("percentage of the key space loaded before each run");
+  program.add_argument("--validate")
+      .help("check every lookup and the final index contents against a reference map")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--json").help("print the results as JSON").default_value(false).implicit_value(true);
+
+  BenchOptions options;
+  try {
+    program.parse_args(argc, argv);
+
+    if (program.present("--duration")) {
+      options.duration_ms_ = std::stoull(program.get("--duration"));
+    }
+    if (program.present("--shards")) {
+      options.shards_ = std::stoull(program.get("--shards"));
+    }
+    if (program.present("--threads")) {
+      options.threads_.clear();
+      for (const auto &threads : bustub::StringUtil::Split(program.get("--threads"), ',')) {
+        options.threads_.push_back(std::stoull(threads));
+      }
+    }
+    if (program.present("--keys")) {
+      options.total_keys_ = std::stoull(program.get("--keys"));
+    }
+    if (program.present("--bpm-size")) {
+      options.bpm_size_ = std::stoull(program.get("--bpm-size"));
+    }
+    if (program.present("--lru-k")) {
+      options.lru_k_size_ = std::stoull(program.get("--lru-k"));
+    }
+    if (program.present("--distribution")) {
+      auto distribution = program.get("--distribution");
+      if (distribution != "uniform" && distribution != "zipfian") {
+        throw std::runtime_error(fmt::format("unknown distribution: {}", distribution));
+      }
+      options.zipfian_ = distribution == "zipfian";
+    }
+    if (program.present("--zipfian-theta")) {
+      options.zipfian_theta_ = std::stod(program.get("--zipfian-theta"));
+    }
+    if (program.present("--mix")) {
+      auto weights = bustub::StringUtil::Split(program.get("--mix"), ':');
+      if (weights.size() != NUM_OP_TYPES) {
+        throw std::runtime_error("--mix takes four weights: read:insert:delete:scan");
       }
+      for (size_t op = 0; op < NUM_OP_TYPES; op++) {
+        options.mix_[op] = std::stoull(weights[op]);
+      }
+    }
+    if (program.present("--scan-length")) {
+      options.scan_length_ = std::stoull(program.get("--scan-length"));
+    }
+    if (program.present("--preload")) {
+      options.preload_pct_ = std::stoull(program.get("--preload"));
+    }
+    options.validate_ = program.get<bool>("--validate");
+    options.json_ = program.get<bool>("--json");
 
-      total_metrics.ReportWrite(metrics.cnt_);
-    }));
+    if (options.threads_.empty() || options.total_keys_ == 0 || options.scan_length_ == 0 ||
+        std::all_of(options.mix_.begin(), options.mix_.end(), [](size_t weight) { return weight == 0; })) {
+      throw std::runtime_error("threads, keys, scan length and at least one operation weight must be positive");
+    }
+    // Keys are stored in the page id of their value as well.
+    if (options.total_keys_ > static_cast<size_t>(std::numeric_limits<bustub::page_id_t>::max())) {
+      throw std::runtime_error("too many keys");
+    }
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
   }
 
-  for (auto &thread : threads) {
-    thread.join();
+  fmt::print(stderr,
+             "[info] page_size={}, total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}, shards={}, "
+             "distribution={}, mix={}:{}:{}:{}, validate={}\n",
+             bustub::BUSTUB_PAGE_SIZE, options.total_keys_, options.duration_ms_, options.lru_k_size_,
+             options.bpm_size_, options.shards_, options.zipfian_ ? "zipfian" : "uniform", options.mix_[0],
+             options.mix_[1], options.mix_[2], options.mix_[3], options.validate_);
+
+  std::vector<RunResult> results;
+  size_t validation_errors = 0;
+  for (auto num_threads : options.threads_) {
+    results.push_back(RunBench(options, num_threads));
+    validation_errors += results.back().validation_errors_;
   }
 
-  total_metrics.Report();
+  if (options.json_) {
+    PrintJson(options, results);
+  } else {
+    PrintText(options, results);
+  }
 
-  return 0;
+  return validation_errors == 0 ? 0 : 1;
 }
@@ -75,6 +75,20 @@ auto ProcessExtraOptions(const std::string &sql, bustub::BustubInstance &instanc
           fmt::print("IndexScan not found\n");
           return false;
         }
+      } else if (opt == "ensure:reverse_index_scan") {
+        if (!bustub::StringUtil::Contains(result.str(), "IndexScan") ||
+            !bustub::StringUtil::Contains(result.str(), "reverse=true")) {
+          fmt::print("reverse IndexScan not found\n");
+          return false;
+        }
+      } else if (bustub::StringUtil::StartsWith(opt, "ensure:scan_columns=")) {
+        // The columns are given without spaces, e.g. ensure:scan_columns=0,2 for a scan that reads columns=[0, 2].
+        auto columns = bustub::StringUtil::Split(opt.substr(std::string("ensure:scan_columns=").size()), ',');
+        auto expected = fmt::format("columns=[{}]", fmt::join(columns, ", "));
+        if (!bustub::StringUtil::Contains(result.str(), expected)) {
+          fmt::print("SeqScan with {} not found\n", expected);
+          return false;
+        }
       } else if (opt == "ensure:hash_join") {
         if (bustub::StringUtil::Split(result.str(), "HashJoin").size() != 2 &&
             !bustub::StringUtil::Contains(result.str(), "Filter")) {